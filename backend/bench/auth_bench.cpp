@@ -0,0 +1,82 @@
+// Times authenticate() with JWTs and with opaque session ids: logs in bench_users
+// users, then authenticates bench_requests tokens round-robin. The first pass over
+// the users is reported apart, as a JWT is only verified there and comes from the
+// token cache after that.
+//
+// The server's own settings apply (--jwt-secret, --token-cache-entries,
+// --opaque-sessions, ...), plus the bench_* ones below; see commands.txt for how
+// to build it.
+#define main server_main
+#include "../server.cpp"
+#undef main
+
+double percentile(std::vector<double> &values, double fraction)
+{
+    if (values.empty())
+    {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, static_cast<size_t>(fraction * values.size()))];
+}
+
+bool runAuth(AuthMode mode, const char *name, int users, int requests)
+{
+    auth_mode = mode;
+    std::vector<std::string> tokens;
+    for (int i = 0; i < users; ++i)
+    {
+        tokens.push_back(issueToken("bench_user" + std::to_string(i)).value());
+    }
+
+    std::vector<double> first_ns;
+    std::vector<double> later_ns;
+    for (int i = 0; i < requests; ++i)
+    {
+        auto start = std::chrono::steady_clock::now();
+        bool ok    = authenticate(tokens[i % users]).has_value();
+        double ns  = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        if (!ok)
+        {
+            std::cerr << name << ": a token was refused\n";
+            return false;
+        }
+        (i < users ? first_ns : later_ns).push_back(ns);
+    }
+
+    std::cout << std::left << std::setw(8) << name << std::right << std::fixed << std::setprecision(0)
+              << std::setw(10) << percentile(first_ns, 0.5) << std::setw(10) << percentile(first_ns, 0.99)
+              << std::setw(10) << percentile(later_ns, 0.5) << std::setw(10) << percentile(later_ns, 0.99) << "\n";
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    using Kind = Config::Kind;
+    config.define("bench_users", Kind::Int, "1000", "users logged in", 1, 1 << 20);
+    config.define("bench_requests", Kind::Int, "200000", "authenticate() calls per auth mode", 1, 1 << 30);
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--help")
+        {
+            config.printHelp(std::cout);
+            return 0;
+        }
+    }
+    if (!config.load(argc, argv))
+    {
+        return 1;
+    }
+    jwt_secret = config.getString("jwt_secret");
+    token_cache.setCapacity(static_cast<size_t>(config.getInt("token_cache_entries")));
+    opaque_sessions.setCapacity(static_cast<size_t>(config.getInt("opaque_sessions")));
+    const int users    = static_cast<int>(config.getInt("bench_users"));
+    const int requests = std::max(users, static_cast<int>(config.getInt("bench_requests")));
+
+    std::cout << users << " users, " << requests << " authenticate() calls per mode\n";
+    std::cout << std::left << std::setw(8) << "tokens" << std::right << std::setw(10) << "first50" << std::setw(10)
+              << "first99" << std::setw(10) << "later50" << std::setw(10) << "later99" << "  (ns)\n";
+    bool ok = runAuth(AuthMode::Jwt, "jwt", users, requests);
+    ok      = runAuth(AuthMode::Opaque, "opaque", users, requests) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,109 @@
+// Compares jwt::decode (plus jwt::verify) with jwt::decoded_jwt_view on an HS256
+// login token, reading the claims authenticate() reads: iss, sub and exp. Reports
+// the time and the heap allocations per token, counted by replacing operator new.
+// Usage: jwt_decode_bench [iterations]
+#include "../jwt-cpp/jwt.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+// The replacement operators below pair malloc with free. GCC cannot see that
+// through the inlined allocators and warns that the two are mismatched.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+namespace
+{
+std::atomic<long> allocations{0};
+}
+
+void *operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+struct Sample
+{
+    double ns;
+    double allocations;
+};
+
+template <typename F>
+Sample measure(long iterations, F &&body)
+{
+    long before = allocations.load();
+    auto start  = std::chrono::steady_clock::now();
+    for (long i = 0; i < iterations; ++i)
+    {
+        body();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return Sample{std::chrono::duration<double, std::nano>(end - start).count() / iterations,
+                  static_cast<double>(allocations.load() - before) / iterations};
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    long iterations = argc > 1 ? std::atol(argv[1]) : 200000;
+    if (iterations < 1)
+    {
+        std::fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+        return 1;
+    }
+    const std::string token = jwt::create()
+                                  .set_issuer("auction_system")
+                                  .set_subject("myUsername")
+                                  .set_expires_at(std::chrono::system_clock::now() + std::chrono::hours(1))
+                                  .sign(jwt::algorithm::hs256{"secret"});
+
+    size_t sink = 0;
+    Sample decode_verify = measure(iterations, [&]
+                                   {
+        auto decoded = jwt::decode(token);
+        jwt::verify().allow_algorithm(jwt::algorithm::hs256{"secret"}).with_issuer("auction_system").verify(decoded);
+        sink += decoded.get_subject().size() + decoded.get_expires_at().time_since_epoch().count() % 2; });
+    Sample view_verify = measure(iterations, [&]
+                                 {
+        jwt::decoded_jwt_view view(token);
+        std::error_code ec;
+        view.verify(jwt::algorithm::hs256{"secret"}, ec);
+        if (!ec && view.get_issuer() == "auction_system")
+        {
+            sink += view.get_subject().size() + view.get_expires_at().time_since_epoch().count() % 2;
+        } });
+    Sample decode_only = measure(iterations, [&]
+                                 { sink += jwt::decode(token).get_subject().size(); });
+    Sample view_only = measure(iterations, [&]
+                               { sink += jwt::decoded_jwt_view(token).get_subject().size(); });
+
+    std::printf("%ld tokens of %zu bytes\n", iterations, token.size());
+    std::printf("jwt::decode + jwt::verify   %6.0f ns  %5.1f allocations\n", decode_verify.ns, decode_verify.allocations);
+    std::printf("decoded_jwt_view + verify   %6.0f ns  %5.1f allocations\n", view_verify.ns, view_verify.allocations);
+    std::printf("jwt::decode alone           %6.0f ns  %5.1f allocations\n", decode_only.ns, decode_only.allocations);
+    std::printf("decoded_jwt_view alone      %6.0f ns  %5.1f allocations  (%zu)\n", view_only.ns, view_only.allocations,
+                sink % 10);
+    return 0;
+}
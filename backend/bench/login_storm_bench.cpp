@@ -0,0 +1,153 @@
+// Login storm: submits bench_logins password checks at once and, while they run,
+// times a stream of small read tasks on the task executor, as /auctions would
+// submit them. Runs twice: with the checks on a separate hasher pool, as the
+// server does, and with them on the executor itself, as before the hasher existed.
+//
+// The server's own settings apply (--workers, --hash-workers, --hash-queue,
+// --pbkdf2-iterations, ...), plus the bench_* ones below; see commands.txt for how
+// to build it.
+#define main server_main
+#include "../server.cpp"
+#undef main
+
+struct StormResult
+{
+    double seconds = 0;
+    size_t logins = 0;
+    size_t shed = 0;
+    std::vector<double> login_ms;
+    std::vector<double> read_ms;
+};
+
+double percentile(std::vector<double> &values, double fraction)
+{
+    if (values.empty())
+    {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, static_cast<size_t>(fraction * values.size()))];
+}
+
+double millisSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+StormResult runStorm(bool on_hasher, const std::string &stored, int logins, int read_interval_ms)
+{
+    TaskExecutor reads;
+    TaskExecutor hashes;
+    reads.start(static_cast<size_t>(config.getInt("workers")), static_cast<size_t>(config.getInt("worker_queue")),
+                config.getCpus("worker_cpus"));
+    if (on_hasher)
+    {
+        hashes.start(static_cast<size_t>(config.getInt("hash_workers")), static_cast<size_t>(config.getInt("hash_queue")),
+                     config.getCpus("hash_cpus"));
+    }
+    TaskExecutor &pool = on_hasher ? hashes : reads;
+    TaskType type      = on_hasher ? TaskType::Hash : TaskType::Auth;
+
+    StormResult result;
+    std::mutex mutex;
+    std::vector<std::future<void>> checks;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < logins; ++i)
+    {
+        auto submitted = std::chrono::steady_clock::now();
+        try
+        {
+            checks.push_back(pool.submit(type, [&, submitted]
+                                         {
+                checkPassword("hunter2", stored);
+                std::lock_guard<std::mutex> lock(mutex);
+                result.login_ms.push_back(millisSince(submitted)); }));
+        }
+        catch (const ExecutorFull &)
+        {
+            ++result.shed;
+        }
+    }
+
+    // Reads keep arriving until the last check has finished
+    auto pending = [&]
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return result.login_ms.size() < checks.size();
+    };
+    while (pending())
+    {
+        auto submitted = std::chrono::steady_clock::now();
+        try
+        {
+            reads.submit(TaskType::Read, [] {}).get();
+            result.read_ms.push_back(millisSince(submitted));
+        }
+        catch (const ExecutorFull &)
+        {
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(read_interval_ms));
+    }
+    for (auto &check : checks)
+    {
+        check.get();
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.logins  = checks.size();
+
+    reads.stop();
+    if (on_hasher)
+    {
+        hashes.stop();
+    }
+    return result;
+}
+
+void report(const char *name, StormResult &result)
+{
+    std::cout << std::left << std::setw(10) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(9) << result.logins / result.seconds << std::setw(6) << result.shed
+              << std::setprecision(0) << std::setw(9) << percentile(result.login_ms, 0.5) << std::setw(9)
+              << percentile(result.login_ms, 0.99) << std::setprecision(1) << std::setw(9)
+              << percentile(result.read_ms, 0.5) << std::setw(9) << percentile(result.read_ms, 0.99) << std::setw(9)
+              << percentile(result.read_ms, 1.0) << "\n";
+}
+
+int main(int argc, char **argv)
+{
+    using Kind = Config::Kind;
+    config.define("bench_logins", Kind::Int, "200", "password checks submitted at once", 1, 1 << 20);
+    config.define("bench_read_interval_ms", Kind::Int, "2", "pause between read tasks", 0, 1000);
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--help")
+        {
+            config.printHelp(std::cout);
+            return 0;
+        }
+    }
+    if (!config.load(argc, argv))
+    {
+        return 1;
+    }
+    pbkdf2_iterations = static_cast<int>(config.getInt("pbkdf2_iterations"));
+    const int logins        = static_cast<int>(config.getInt("bench_logins"));
+    const int read_interval = static_cast<int>(config.getInt("bench_read_interval_ms"));
+
+    const std::string stored = hashPassword("hunter2");
+    auto one = std::chrono::steady_clock::now();
+    checkPassword("hunter2", stored);
+    std::cout << logins << " logins, PBKDF2 " << pbkdf2_iterations << " iterations (" << std::fixed
+              << std::setprecision(1) << millisSince(one) << " ms each), " << config.getInt("workers")
+              << " workers (queue " << config.getInt("worker_queue") << "), " << config.getInt("hash_workers")
+              << " hash workers (queue " << config.getInt("hash_queue") << ")\n";
+    std::cout << std::left << std::setw(10) << "checks on" << std::right << std::setw(9) << "logins/s" << std::setw(6)
+              << "shed" << std::setw(9) << "login50" << std::setw(9) << "login99" << std::setw(9) << "read50"
+              << std::setw(9) << "read99" << std::setw(9) << "readmax" << "  (ms)\n";
+
+    StormResult hasher_run = runStorm(true, stored, logins, read_interval);
+    report("hasher", hasher_run);
+    StormResult executor_run = runStorm(false, stored, logins, read_interval);
+    report("executor", executor_run);
+    return 0;
+}
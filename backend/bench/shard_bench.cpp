@@ -0,0 +1,192 @@
+// Load driver for the bid path: runs the bid shards and the group committer
+// against a scratch database, with no HTTP in front, at a few shard counts, and
+// prints the bid throughput of each. Client threads keep a fixed number of bids
+// in flight each, on auctions picked at random, with ever-increasing amounts.
+//
+// The server's own settings apply (--commit-window-us, --db-synchronous, ...),
+// plus the bench_* ones below; see commands.txt for how to build it.
+#define main server_main
+#include "../server.cpp"
+#undef main
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+struct BenchResult
+{
+    double seconds = 0;
+    unsigned long long completed = 0;
+    unsigned long long accepted = 0;
+};
+
+// One run, in a child process so that every run starts from fresh globals
+BenchResult runBench(int shards, long long auctions, int clients, long long bids, int window)
+{
+    const std::string path = config.getString("db_path");
+    for (const char *suffix : {"", "-wal", "-shm"})
+    {
+        std::remove((path + suffix).c_str());
+    }
+    if (!db_pool.open(dbOptionsFromConfig(config)) || !setupDatabase())
+    {
+        std::cerr << "Can't open " << path << "\n";
+        std::exit(1);
+    }
+    {
+        auto db = db_pool.writer();
+        sqlite3_exec(db->handle(), "BEGIN;", nullptr, nullptr, nullptr);
+        for (long long i = 0; i < auctions; ++i)
+        {
+            AuctionRecord record;
+            record.item  = "item " + std::to_string(i);
+            record.owner = "seller";
+            long long id;
+            insertAuction(*db, record, id);
+        }
+        sqlite3_exec(db->handle(), "COMMIT;", nullptr, nullptr, nullptr);
+    }
+
+    const size_t mailbox = static_cast<size_t>(config.getInt("bid_mailbox"));
+    for (int i = 0; i < shards; ++i)
+    {
+        bid_shards.push_back(std::make_unique<BidShard>(mailbox));
+    }
+    loadAuctionBook();
+    group_committer.start(db_pool, groupCommitOptionsFromConfig(config));
+    for (auto &shard : bid_shards)
+    {
+        shard->start(config.getCpus("shard_cpus"));
+    }
+
+    std::atomic<long long> next_amount{1};
+    std::atomic<unsigned long long> completed{0};
+    std::atomic<unsigned long long> accepted{0};
+    const long long per_client = bids / clients;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int c = 0; c < clients; ++c)
+    {
+        threads.emplace_back([&, c]
+                             {
+            std::mt19937 rng(static_cast<unsigned>(c));
+            std::uniform_int_distribution<long long> pick(1, auctions);
+            std::string bidder = "bidder" + std::to_string(c);
+            std::atomic<int> in_flight{0};
+            for (long long i = 0; i < per_client; ++i)
+            {
+                while (in_flight.load(std::memory_order_acquire) >= window)
+                {
+                    std::this_thread::yield();
+                }
+                int auction_id = static_cast<int>(pick(rng));
+                double amount  = static_cast<double>(next_amount.fetch_add(1, std::memory_order_relaxed));
+                in_flight.fetch_add(1, std::memory_order_relaxed);
+                while (!shardFor(auction_id).placeBid(auction_id, amount, bidder, nowEpoch(), [&](const BidOutcome &outcome)
+                                                      {
+                    if (outcome.status == BidStatus::Accepted)
+                    {
+                        accepted.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    completed.fetch_add(1, std::memory_order_relaxed);
+                    in_flight.fetch_sub(1, std::memory_order_release); }))
+                {
+                    std::this_thread::yield();
+                }
+            }
+            while (in_flight.load(std::memory_order_acquire) > 0)
+            {
+                std::this_thread::yield();
+            } });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    BenchResult result;
+    result.seconds   = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.completed = completed.load();
+    result.accepted  = accepted.load();
+
+    for (auto &shard : bid_shards)
+    {
+        shard->stop();
+    }
+    group_committer.stop();
+    db_pool.close();
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    using Kind = Config::Kind;
+    const std::string cores = std::to_string(std::max(1u, std::thread::hardware_concurrency()));
+    config.define("bench_shards", Kind::String, "1,2,4," + cores, "shard counts to run, comma-separated");
+    config.define("bench_auctions", Kind::Int, "1024", "auctions bid on", 1);
+    config.define("bench_clients", Kind::Int, "16", "client threads", 1);
+    config.define("bench_bids", Kind::Int, "200000", "bids per run", 1);
+    config.define("bench_window", Kind::Int, "64", "bids in flight per client", 1);
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--help")
+        {
+            config.printHelp(std::cout);
+            return 0;
+        }
+    }
+    // Never the server's own database, unless --db-path says so
+    std::vector<char *> args(argv, argv + argc);
+    std::string scratch = "--db-path=shard_bench.db";
+    args.insert(args.begin() + 1, &scratch[0]);
+    if (!config.load(static_cast<int>(args.size()), args.data()))
+    {
+        return 1;
+    }
+
+    const long long auctions = config.getInt("bench_auctions");
+    const int clients        = static_cast<int>(config.getInt("bench_clients"));
+    const long long bids     = config.getInt("bench_bids");
+    const int window         = static_cast<int>(config.getInt("bench_window"));
+    std::cout << auctions << " auctions, " << clients << " clients with " << window << " bids in flight each, "
+              << bids << " bids per run, commit window " << config.getInt("commit_window_us") << "us, synchronous="
+              << config.getString("db_synchronous") << "\n";
+    std::cout << std::left << std::setw(8) << "shards" << std::setw(14) << "bids/s" << "accepted\n";
+
+    std::stringstream counts(config.getString("bench_shards"));
+    std::string count;
+    while (std::getline(counts, count, ','))
+    {
+        int shards = std::atoi(count.c_str());
+        if (shards < 1)
+        {
+            std::cerr << "Invalid shard count " << count << "\n";
+            return 1;
+        }
+        int fds[2];
+        if (pipe(fds) != 0)
+        {
+            return 1;
+        }
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            close(fds[0]);
+            BenchResult result = runBench(shards, auctions, clients, bids, window);
+            ssize_t written    = write(fds[1], &result, sizeof(result));
+            _exit(written == static_cast<ssize_t>(sizeof(result)) ? 0 : 1);
+        }
+        close(fds[1]);
+        BenchResult result;
+        bool ok = read(fds[0], &result, sizeof(result)) == static_cast<ssize_t>(sizeof(result));
+        close(fds[0]);
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!ok || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+            std::cerr << "Run with " << shards << " shards failed\n";
+            return 1;
+        }
+        std::cout << std::left << std::setw(8) << shards << std::setw(14) << std::fixed << std::setprecision(0)
+                  << result.completed / result.seconds << result.accepted << "\n";
+    }
+    return 0;
+}
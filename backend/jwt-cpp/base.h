@@ -8,6 +8,17 @@
 #include <string>
 #include <vector>
 
+#if __cplusplus >= 201703L
+#include <string_view>
+#define JWT_HAS_STRING_VIEW
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__)) &&                       \
+	!defined(JWT_DISABLE_BASE64_SIMD)
+#define JWT_BASE64_SIMD
+#include <immintrin.h>
+#endif
+
 #ifdef __has_cpp_attribute
 #if __has_cpp_attribute(fallthrough)
 #define JWT_FALLTHROUGH [[fallthrough]]
@@ -163,118 +174,422 @@ namespace jwt {
 				}
 			};
 
+			/// Count the fills repeated at the end of the input, without copying it
 			inline padding count_padding(const std::string& base, const std::vector<std::string>& fills) {
-				for (const auto& fill : fills) {
-					if (base.size() < fill.size()) continue;
-					// Does the end of the input exactly match the fill pattern?
-					if (base.substr(base.size() - fill.size()) == fill) {
-						return padding{1, fill.length()} +
-							   count_padding(base.substr(0, base.size() - fill.size()), fills);
+				padding pad;
+				size_t end = base.size();
+				for (bool matched = true; matched;) {
+					matched = false;
+					for (const auto& fill : fills) {
+						if (fill.empty() || end < fill.size()) continue;
+						// Does the end of the input exactly match the fill pattern?
+						if (base.compare(end - fill.size(), fill.size(), fill) == 0) {
+							pad = pad + padding{1, fill.size()};
+							end -= fill.size();
+							matched = true;
+							break;
+						}
 					}
 				}
+				return pad;
+			}
 
-				return {};
+			inline padding count_padding(const std::string& base, const std::string& fill) {
+				padding pad;
+				if (fill.empty()) return pad;
+				for (size_t end = base.size(); end >= fill.size(); end -= fill.size()) {
+					if (base.compare(end - fill.size(), fill.size(), fill) != 0) break;
+					pad = pad + padding{1, fill.size()};
+				}
+				return pad;
 			}
 
+#ifdef JWT_BASE64_SIMD
+			/**
+			 * \brief Vectorized base64 kernels for x86
+			 *
+			 * The kernels handle the standard letters and digits with the alphabet's own
+			 * characters for 62 and 63, so they serve both base64 and base64url. They only
+			 * process whole groups and leave the rest of the input to the scalar code, which
+			 * is also what reports invalid characters. The instruction set is chosen once,
+			 * at runtime, from what the CPU supports.
+			 */
+			namespace simd {
+				enum class level { none, ssse3, avx2 };
+
+				inline level detect() {
+					__builtin_cpu_init();
+					if (__builtin_cpu_supports("avx2")) return level::avx2;
+					if (__builtin_cpu_supports("ssse3")) return level::ssse3;
+					return level::none;
+				}
+
+				inline level supported() {
+					static const level l = detect();
+					return l;
+				}
+
+				/// The characters for 62 and 63 of the alphabets the kernels support
+				inline bool special_chars(const std::array<char, 64>& data, char& c62, char& c63) {
+					if (&data != &alphabet::base64::data() && &data != &alphabet::base64url::data() &&
+						&data != &alphabet::helper::base64url_percent_encoding::data())
+						return false;
+					c62 = data[62];
+					c63 = data[63];
+					return true;
+				}
+
+				inline bool special_chars(const std::array<int8_t, 256>& rdata, char& c62, char& c63) {
+					if (&rdata == &alphabet::base64::rdata()) {
+						c62 = alphabet::base64::data()[62];
+						c63 = alphabet::base64::data()[63];
+						return true;
+					}
+					if (&rdata == &alphabet::base64url::rdata() ||
+						&rdata == &alphabet::helper::base64url_percent_encoding::rdata()) {
+						c62 = alphabet::base64url::data()[62];
+						c63 = alphabet::base64url::data()[63];
+						return true;
+					}
+					return false;
+				}
+
+				// Sextet indices to characters: a shuffle picks the offset to add for each range
+				__attribute__((target("ssse3"))) inline __m128i encode_chars(__m128i indices, char c62, char c63) {
+					const __m128i offsets =
+						_mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+									  '0' - 52, '0' - 52, '0' - 52, static_cast<char>(c62 - 62),
+									  static_cast<char>(c63 - 63), 'A', 0, 0);
+					__m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+					const __m128i upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+					range = _mm_or_si128(range, _mm_and_si128(upper, _mm_set1_epi8(13)));
+					return _mm_add_epi8(_mm_shuffle_epi8(offsets, range), indices);
+				}
+
+				// Spreads each 3 bytes of a 12 byte group over 4 bytes holding a sextet each
+				__attribute__((target("ssse3"))) inline __m128i encode_indices(__m128i in) {
+					in = _mm_shuffle_epi8(in, _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+					const __m128i ac = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)),
+													   _mm_set1_epi32(0x04000040));
+					const __m128i bd = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003f03f0)),
+													   _mm_set1_epi32(0x01000010));
+					return _mm_or_si128(ac, bd);
+				}
+
+				__attribute__((target("ssse3"))) inline size_t encode_ssse3(const char* in, size_t size, char* out,
+																			  char c62, char c63) {
+					size_t i = 0;
+					// Each step reads 16 bytes and uses 12 of them
+					for (; i + 16 <= size; i += 12, out += 16) {
+						const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(out), encode_chars(encode_indices(bytes), c62, c63));
+					}
+					return i;
+				}
+
+				__attribute__((target("avx2"))) inline size_t encode_avx2(const char* in, size_t size, char* out,
+																			char c62, char c63) {
+					const __m256i shuffle = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10, 1, 0,
+															 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+					const __m256i offsets = _mm256_setr_epi8(
+						'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+						'0' - 52, '0' - 52, static_cast<char>(c62 - 62), static_cast<char>(c63 - 63), 'A', 0, 0,
+						'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+						'0' - 52, '0' - 52, static_cast<char>(c62 - 62), static_cast<char>(c63 - 63), 'A', 0, 0);
+					size_t i = 0;
+					// Each step reads 28 bytes and uses 24 of them, 12 per 128 bit lane
+					for (; i + 28 <= size; i += 24, out += 32) {
+						__m256i bytes = _mm256_inserti128_si256(
+							_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i))),
+							_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 12)), 1);
+						bytes = _mm256_shuffle_epi8(bytes, shuffle);
+						const __m256i ac = _mm256_mulhi_epu16(_mm256_and_si256(bytes, _mm256_set1_epi32(0x0fc0fc00)),
+															  _mm256_set1_epi32(0x04000040));
+						const __m256i bd = _mm256_mullo_epi16(_mm256_and_si256(bytes, _mm256_set1_epi32(0x003f03f0)),
+															  _mm256_set1_epi32(0x01000010));
+						const __m256i indices = _mm256_or_si256(ac, bd);
+
+						__m256i range = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+						const __m256i upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+						range = _mm256_or_si256(range, _mm256_and_si256(upper, _mm256_set1_epi8(13)));
+						const __m256i chars = _mm256_add_epi8(_mm256_shuffle_epi8(offsets, range), indices);
+						_mm256_storeu_si256(reinterpret_cast<__m256i*>(out), chars);
+					}
+					return i + encode_ssse3(in + i, size - i, out, c62, c63);
+				}
+
+				/**
+				 * Encode the longest prefix of whole 3 byte groups the kernels can, writing
+				 * 4 characters per group to out
+				 *
+				 * \return Number of input bytes encoded
+				 */
+				inline size_t encode(const char* in, size_t size, char* out, char c62, char c63) {
+					switch (supported()) {
+					case level::avx2: return encode_avx2(in, size, out, c62, c63);
+					case level::ssse3: return encode_ssse3(in, size, out, c62, c63);
+					default: return 0;
+					}
+				}
+
+				/// Lanes of in between lo and hi
+				__attribute__((target("ssse3"))) inline __m128i in_range(__m128i in, char lo, char hi) {
+					return _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8(static_cast<char>(lo - 1))),
+										 _mm_cmplt_epi8(in, _mm_set1_epi8(static_cast<char>(hi + 1))));
+				}
+
+				__attribute__((target("avx2"))) inline __m256i in_range(__m256i in, char lo, char hi) {
+					return _mm256_and_si256(_mm256_cmpgt_epi8(in, _mm256_set1_epi8(static_cast<char>(lo - 1))),
+											_mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(hi + 1)), in));
+				}
+
+				// Characters to sextets; a lane is set in invalid when its character is not in the alphabet
+				__attribute__((target("ssse3"))) inline __m128i decode_sextets(__m128i in, char c62, char c63,
+																				 __m128i& invalid) {
+					const __m128i upper = in_range(in, 'A', 'Z');
+					const __m128i lower = in_range(in, 'a', 'z');
+					const __m128i digit = in_range(in, '0', '9');
+					const __m128i is62 = _mm_cmpeq_epi8(in, _mm_set1_epi8(c62));
+					const __m128i is63 = _mm_cmpeq_epi8(in, _mm_set1_epi8(c63));
+
+					__m128i offset = _mm_and_si128(upper, _mm_set1_epi8(-'A'));
+					offset = _mm_or_si128(offset, _mm_and_si128(lower, _mm_set1_epi8(26 - 'a')));
+					offset = _mm_or_si128(offset, _mm_and_si128(digit, _mm_set1_epi8(52 - '0')));
+					offset = _mm_or_si128(offset, _mm_and_si128(is62, _mm_set1_epi8(static_cast<char>(62 - c62))));
+					offset = _mm_or_si128(offset, _mm_and_si128(is63, _mm_set1_epi8(static_cast<char>(63 - c63))));
+
+					const __m128i valid =
+						_mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(digit, _mm_or_si128(is62, is63)));
+					invalid = _mm_or_si128(invalid, _mm_xor_si128(valid, _mm_set1_epi8(-1)));
+					return _mm_add_epi8(in, offset);
+				}
+
+				// Packs each 4 sextets into 3 bytes, leaving 12 bytes at the start of the register
+				__attribute__((target("ssse3"))) inline __m128i decode_pack(__m128i sextets) {
+					const __m128i pairs = _mm_maddubs_epi16(sextets, _mm_set1_epi32(0x01400140));
+					const __m128i words = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+					return _mm_shuffle_epi8(words, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+				}
+
+				__attribute__((target("ssse3"))) inline size_t decode_ssse3(const char* in, size_t size, char* out,
+																			  char c62, char c63) {
+					size_t i = 0;
+					// Each step writes 16 bytes, of which 12 are output
+					for (; i + 16 <= size; i += 16, out += 12) {
+						__m128i invalid = _mm_setzero_si128();
+						const __m128i sextets = decode_sextets(
+							_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)), c62, c63, invalid);
+						if (_mm_movemask_epi8(invalid) != 0) break;
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(out), decode_pack(sextets));
+					}
+					return i;
+				}
+
+				__attribute__((target("avx2"))) inline size_t decode_avx2(const char* in, size_t size, char* out,
+																			char c62, char c63) {
+					size_t i = 0;
+					// Each step writes 32 bytes, of which 24 are output
+					for (; i + 32 <= size; i += 32, out += 24) {
+						const __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+						const __m256i upper = in_range(chars, 'A', 'Z');
+						const __m256i lower = in_range(chars, 'a', 'z');
+						const __m256i digit = in_range(chars, '0', '9');
+						const __m256i is62 = _mm256_cmpeq_epi8(chars, _mm256_set1_epi8(c62));
+						const __m256i is63 = _mm256_cmpeq_epi8(chars, _mm256_set1_epi8(c63));
+						const __m256i valid = _mm256_or_si256(_mm256_or_si256(upper, lower),
+															  _mm256_or_si256(digit, _mm256_or_si256(is62, is63)));
+						if (_mm256_movemask_epi8(valid) != -1) break;
+
+						__m256i offset = _mm256_and_si256(upper, _mm256_set1_epi8(-'A'));
+						offset = _mm256_or_si256(offset, _mm256_and_si256(lower, _mm256_set1_epi8(26 - 'a')));
+						offset = _mm256_or_si256(offset, _mm256_and_si256(digit, _mm256_set1_epi8(52 - '0')));
+						offset = _mm256_or_si256(
+							offset, _mm256_and_si256(is62, _mm256_set1_epi8(static_cast<char>(62 - c62))));
+						offset = _mm256_or_si256(
+							offset, _mm256_and_si256(is63, _mm256_set1_epi8(static_cast<char>(63 - c63))));
+						const __m256i sextets = _mm256_add_epi8(chars, offset);
+
+						const __m256i pairs = _mm256_maddubs_epi16(sextets, _mm256_set1_epi32(0x01400140));
+						__m256i bytes = _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+						bytes = _mm256_shuffle_epi8(bytes, _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1,
+																			-1, -1, -1, 2, 1, 0, 6, 5, 4, 10, 9, 8, 14,
+																			13, 12, -1, -1, -1, -1));
+						// Close the gap between the 12 bytes of each lane
+						bytes = _mm256_permutevar8x32_epi32(bytes, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+						_mm256_storeu_si256(reinterpret_cast<__m256i*>(out), bytes);
+					}
+					return i + decode_ssse3(in + i, size - i, out, c62, c63);
+				}
+
+				/// Bytes past the decoded output that the kernels may overwrite
+				constexpr size_t decode_slack = 8;
+
+				/**
+				 * Decode the longest prefix of whole 4 character groups the kernels can, up to
+				 * the first group holding a character outside the alphabet, writing 3 bytes
+				 * per group to out. decode_slack bytes after those may be overwritten.
+				 *
+				 * \return Number of input characters decoded
+				 */
+				inline size_t decode(const char* in, size_t size, char* out, char c62, char c63) {
+					switch (supported()) {
+					case level::avx2: return decode_avx2(in, size, out, c62, c63);
+					case level::ssse3: return decode_ssse3(in, size, out, c62, c63);
+					default: return 0;
+					}
+				}
+			} // namespace simd
+#endif
+
 			inline std::string encode(const std::string& bin, const std::array<char, 64>& alphabet,
 									  const std::string& fill) {
 				size_t size = bin.size();
-				std::string res;
+				size_t fast_size = size - size % 3;
+				size_t mod = size % 3;
 
+				std::string res(fast_size / 3 * 4 + (mod == 0 ? 0 : mod + 1 + (3 - mod) * fill.size()), '\0');
+				const char* in = bin.data();
+				char* out = &res[0];
+
+				size_t i = 0;
+#ifdef JWT_BASE64_SIMD
+				char c62, c63;
+				if (simd::special_chars(alphabet, c62, c63)) {
+					i = simd::encode(in, fast_size, out, c62, c63);
+					out += i / 3 * 4;
+				}
+#endif
 				// clear incomplete bytes
-				size_t fast_size = size - size % 3;
-				for (size_t i = 0; i < fast_size;) {
-					uint32_t octet_a = static_cast<unsigned char>(bin[i++]);
-					uint32_t octet_b = static_cast<unsigned char>(bin[i++]);
-					uint32_t octet_c = static_cast<unsigned char>(bin[i++]);
+				for (; i < fast_size;) {
+					uint32_t octet_a = static_cast<unsigned char>(in[i++]);
+					uint32_t octet_b = static_cast<unsigned char>(in[i++]);
+					uint32_t octet_c = static_cast<unsigned char>(in[i++]);
 
 					uint32_t triple = (octet_a << 0x10) + (octet_b << 0x08) + octet_c;
 
-					res += alphabet[(triple >> 3 * 6) & 0x3F];
-					res += alphabet[(triple >> 2 * 6) & 0x3F];
-					res += alphabet[(triple >> 1 * 6) & 0x3F];
-					res += alphabet[(triple >> 0 * 6) & 0x3F];
+					*out++ = alphabet[(triple >> 3 * 6) & 0x3F];
+					*out++ = alphabet[(triple >> 2 * 6) & 0x3F];
+					*out++ = alphabet[(triple >> 1 * 6) & 0x3F];
+					*out++ = alphabet[(triple >> 0 * 6) & 0x3F];
 				}
 
 				if (fast_size == size) return res;
 
-				size_t mod = size % 3;
-
-				uint32_t octet_a = fast_size < size ? static_cast<unsigned char>(bin[fast_size++]) : 0;
-				uint32_t octet_b = fast_size < size ? static_cast<unsigned char>(bin[fast_size++]) : 0;
-				uint32_t octet_c = fast_size < size ? static_cast<unsigned char>(bin[fast_size++]) : 0;
+				uint32_t octet_a = fast_size < size ? static_cast<unsigned char>(in[fast_size++]) : 0;
+				uint32_t octet_b = fast_size < size ? static_cast<unsigned char>(in[fast_size++]) : 0;
+				uint32_t octet_c = fast_size < size ? static_cast<unsigned char>(in[fast_size++]) : 0;
 
 				uint32_t triple = (octet_a << 0x10) + (octet_b << 0x08) + octet_c;
 
-				switch (mod) {
-				case 1:
-					res += alphabet[(triple >> 3 * 6) & 0x3F];
-					res += alphabet[(triple >> 2 * 6) & 0x3F];
-					res += fill;
-					res += fill;
-					break;
-				case 2:
-					res += alphabet[(triple >> 3 * 6) & 0x3F];
-					res += alphabet[(triple >> 2 * 6) & 0x3F];
-					res += alphabet[(triple >> 1 * 6) & 0x3F];
-					res += fill;
-					break;
-				default: break;
-				}
+				*out++ = alphabet[(triple >> 3 * 6) & 0x3F];
+				*out++ = alphabet[(triple >> 2 * 6) & 0x3F];
+				if (mod == 2) *out++ = alphabet[(triple >> 1 * 6) & 0x3F];
+				for (size_t n = 3 - mod; n > 0; --n, out += fill.size())
+					std::copy(fill.begin(), fill.end(), out);
 
 				return res;
 			}
 
+			/**
+			 * Decode size characters of whole 4 character groups, writing 3 bytes per group
+			 *
+			 * \return Number of bytes written
+			 */
+			inline size_t decode_groups(const char* in, size_t size, const std::array<int8_t, 256>& rdata, char* out) {
+				size_t i = 0;
+				char* const begin = out;
+#ifdef JWT_BASE64_SIMD
+				char c62, c63;
+				if (simd::special_chars(rdata, c62, c63)) {
+					i = simd::decode(in, size, out, c62, c63);
+					out += i / 4 * 3;
+				}
+#endif
+				for (; i < size; i += 4) {
+					uint32_t triple = (alphabet::index(rdata, in[i]) << 3 * 6) +
+									  (alphabet::index(rdata, in[i + 1]) << 2 * 6) +
+									  (alphabet::index(rdata, in[i + 2]) << 1 * 6) +
+									  (alphabet::index(rdata, in[i + 3]) << 0 * 6);
+
+					*out++ = static_cast<char>((triple >> 2 * 8) & 0xFFU);
+					*out++ = static_cast<char>((triple >> 1 * 8) & 0xFFU);
+					*out++ = static_cast<char>((triple >> 0 * 8) & 0xFFU);
+				}
+				return static_cast<size_t>(out - begin);
+			}
+
+#ifdef JWT_BASE64_SIMD
+			constexpr size_t decode_slack = simd::decode_slack;
+#else
+			constexpr size_t decode_slack = 0;
+#endif
+
 			inline std::string decode(const std::string& base, const std::array<int8_t, 256>& rdata,
-									  const std::vector<std::string>& fill) {
-				const auto pad = count_padding(base, fill);
+									  const padding& pad) {
 				if (pad.count > 2) throw std::runtime_error("Invalid input: too much fill");
 
 				const size_t size = base.size() - pad.length;
 				if ((size + pad.count) % 4 != 0) throw std::runtime_error("Invalid input: incorrect total size");
 
-				size_t out_size = size / 4 * 3;
-				std::string res;
-				res.reserve(out_size);
-
-				auto get_sextet = [&](size_t offset) { return alphabet::index(rdata, base[offset]); };
-
 				size_t fast_size = size - size % 4;
-				for (size_t i = 0; i < fast_size;) {
-					uint32_t sextet_a = get_sextet(i++);
-					uint32_t sextet_b = get_sextet(i++);
-					uint32_t sextet_c = get_sextet(i++);
-					uint32_t sextet_d = get_sextet(i++);
-
-					uint32_t triple =
-						(sextet_a << 3 * 6) + (sextet_b << 2 * 6) + (sextet_c << 1 * 6) + (sextet_d << 0 * 6);
-
-					res += static_cast<char>((triple >> 2 * 8) & 0xFFU);
-					res += static_cast<char>((triple >> 1 * 8) & 0xFFU);
-					res += static_cast<char>((triple >> 0 * 8) & 0xFFU);
-				}
-
-				if (pad.count == 0) return res;
-
-				uint32_t triple = (get_sextet(fast_size) << 3 * 6) + (get_sextet(fast_size + 1) << 2 * 6);
-
-				switch (pad.count) {
-				case 1:
-					triple |= (get_sextet(fast_size + 2) << 1 * 6);
-					res += static_cast<char>((triple >> 2 * 8) & 0xFFU);
-					res += static_cast<char>((triple >> 1 * 8) & 0xFFU);
-					break;
-				case 2: res += static_cast<char>((triple >> 2 * 8) & 0xFFU); break;
-				default: break;
+				std::string res(fast_size / 4 * 3 + 2 + decode_slack, '\0');
+				size_t pos = decode_groups(base.data(), fast_size, rdata, &res[0]);
+
+				if (pad.count != 0) {
+					auto get_sextet = [&](size_t offset) { return alphabet::index(rdata, base[offset]); };
+					uint32_t triple = (get_sextet(fast_size) << 3 * 6) + (get_sextet(fast_size + 1) << 2 * 6);
+
+					switch (pad.count) {
+					case 1:
+						triple |= (get_sextet(fast_size + 2) << 1 * 6);
+						res[pos++] = static_cast<char>((triple >> 2 * 8) & 0xFFU);
+						res[pos++] = static_cast<char>((triple >> 1 * 8) & 0xFFU);
+						break;
+					case 2: res[pos++] = static_cast<char>((triple >> 2 * 8) & 0xFFU); break;
+					default: break;
+					}
 				}
 
+				res.resize(pos);
 				return res;
 			}
 
+			inline std::string decode(const std::string& base, const std::array<int8_t, 256>& rdata,
+									  const std::vector<std::string>& fill) {
+				return decode(base, rdata, count_padding(base, fill));
+			}
+
 			inline std::string decode(const std::string& base, const std::array<int8_t, 256>& rdata,
 									  const std::string& fill) {
-				return decode(base, rdata, std::vector<std::string>{fill});
+				return decode(base, rdata, count_padding(base, fill));
+			}
+
+#ifdef JWT_HAS_STRING_VIEW
+			/**
+			 * Decode unpadded input and append the bytes to out, which is resized once so
+			 * a buffer that is reused keeps its capacity
+			 */
+			inline void decode_into(std::string_view base, const std::array<int8_t, 256>& rdata, std::string& out) {
+				const size_t size = base.size();
+				if (size % 4 == 1) throw std::runtime_error("Invalid input: incorrect total size");
+
+				const size_t fast_size = size - size % 4;
+				size_t pos = out.size();
+				out.resize(pos + fast_size / 4 * 3 + 2 + decode_slack);
+				pos += decode_groups(base.data(), fast_size, rdata, &out[pos]);
+
+				if (fast_size != size) {
+					auto get_sextet = [&](size_t offset) { return alphabet::index(rdata, base[offset]); };
+					uint32_t triple = (get_sextet(fast_size) << 3 * 6) + (get_sextet(fast_size + 1) << 2 * 6);
+					out[pos++] = static_cast<char>((triple >> 2 * 8) & 0xFFU);
+					if (size % 4 == 3) {
+						triple |= (get_sextet(fast_size + 2) << 1 * 6);
+						out[pos++] = static_cast<char>((triple >> 1 * 8) & 0xFFU);
+					}
+				}
+				out.resize(pos);
 			}
+#endif
 
 			inline std::string pad(const std::string& base, const std::string& fill) {
 				std::string padding;
@@ -322,6 +637,24 @@ namespace jwt {
 		std::string decode(const std::string& base) {
 			return details::decode(base, T::rdata(), T::fill());
 		}
+#ifdef JWT_HAS_STRING_VIEW
+		/**
+		 * \brief Generic base64 decoding of unpadded input into an existing buffer
+		 * 
+		 * Appends the decoded bytes to out instead of returning a new string, and needs
+		 * no padded copy of the input. This is how token parts, which never carry
+		 * padding, are decoded by jwt::decoded_jwt_view.
+		 * 
+		 * \code
+		 * std::string buffer;
+		 * jwt::base::decode_into<jwt::alphabet::base64url>("ZXhhbXBsZV9kYQ", buffer)
+		 * \endcode
+		 */
+		template<typename T>
+		void decode_into(std::string_view base, std::string& out) {
+			details::decode_into(base, T::rdata(), out);
+		}
+#endif
 		/**
 		 * \brief Generic base64 padding
 		 * 
@@ -25,9 +25,12 @@
 #include <chrono>
 #include <climits>
 #include <cmath>
+#include <cstdlib>
 #include <cstring>
+#include <ctime>
 #include <functional>
 #include <iterator>
+#include <limits>
 #include <locale>
 #include <memory>
 #include <set>
@@ -47,6 +50,7 @@
 
 #if OPENSSL_VERSION_NUMBER >= 0x30000000L // 3.0.0
 #define JWT_OPENSSL_3_0
+#include <openssl/core_names.h>
 #include <openssl/param_build.h>
 #elif OPENSSL_VERSION_NUMBER >= 0x10101000L // 1.1.1
 #define JWT_OPENSSL_1_1_1
@@ -530,6 +534,139 @@ namespace jwt {
 #endif
 		}
 
+		/**
+		 * \brief HMAC context keyed once and reset for every operation
+		 *
+		 * Keying an HMAC context hashes the padded key into the inner and outer digest
+		 * states. A keyed context keeps those states, so every following MAC only resets
+		 * to them instead of going through the key schedule again.
+		 */
+		class keyed_hmac {
+		public:
+#ifdef JWT_OPENSSL_3_0
+			using context = EVP_MAC_CTX;
+#else
+			using context = HMAC_CTX;
+#endif
+			/**
+			 * Construct a context for the given key and hash function
+			 *
+			 * \param md Hash function
+			 * \param key Key to use for HMAC
+			 */
+			keyed_hmac(const EVP_MD* md, std::string key) : md(md), key(std::move(key)), ctx(make_context(this->md, this->key)) {}
+			keyed_hmac(const keyed_hmac&) = delete;
+			keyed_hmac& operator=(const keyed_hmac&) = delete;
+			keyed_hmac(keyed_hmac&&) = default;
+			keyed_hmac& operator=(keyed_hmac&&) = default;
+
+			/// Whether this context was created for the given hash function and key
+			bool matches(const EVP_MD* other_md, const std::string& other_key) const noexcept {
+				return md == other_md && key == other_key;
+			}
+
+			/**
+			 * Compute the MAC of data
+			 *
+			 * \param data The data to authenticate
+			 * \param out Buffer of at least EVP_MAX_MD_SIZE bytes
+			 * \param len Filled with the length of the MAC
+			 * \return false if OpenSSL reported an error
+			 */
+			bool compute(const std::string& data, unsigned char* out, size_t& len) const noexcept {
+				return compute(data.data(), data.size(), out, len);
+			}
+			/**
+			 * Compute the MAC of size bytes at data
+			 *
+			 * \param data The data to authenticate
+			 * \param size Length of data
+			 * \param out Buffer of at least EVP_MAX_MD_SIZE bytes
+			 * \param len Filled with the length of the MAC
+			 * \return false if OpenSSL reported an error
+			 */
+			bool compute(const char* data, size_t size, unsigned char* out, size_t& len) const noexcept {
+				if (!ctx) return false;
+				const auto* in = reinterpret_cast<const unsigned char*>(data);
+#ifdef JWT_OPENSSL_3_0
+				// A null key resets to the keyed state
+				return EVP_MAC_init(ctx.get(), nullptr, 0, nullptr) == 1 &&
+					   EVP_MAC_update(ctx.get(), in, size) == 1 &&
+					   EVP_MAC_final(ctx.get(), out, &len, EVP_MAX_MD_SIZE) == 1;
+#else
+				unsigned int out_len = 0;
+				bool ok = HMAC_Init_ex(ctx.get(), nullptr, 0, nullptr, nullptr) == 1 &&
+						  HMAC_Update(ctx.get(), in, size) == 1 && HMAC_Final(ctx.get(), out, &out_len) == 1;
+				len = out_len;
+				return ok;
+#endif
+			}
+
+		private:
+			static void free_context(context* c) {
+#ifdef JWT_OPENSSL_3_0
+				EVP_MAC_CTX_free(c);
+#elif defined(JWT_OPENSSL_1_0_0)
+				HMAC_CTX_cleanup(c);
+				delete c;
+#else
+				HMAC_CTX_free(c);
+#endif
+			}
+
+			static std::unique_ptr<context, void (*)(context*)> make_context(const EVP_MD* md, const std::string& key) {
+				std::unique_ptr<context, void (*)(context*)> c(nullptr, &free_context);
+#ifdef JWT_OPENSSL_3_0
+				EVP_MAC* mac = EVP_MAC_fetch(nullptr, "HMAC", nullptr);
+				if (mac == nullptr) return c;
+				c.reset(EVP_MAC_CTX_new(mac));
+				EVP_MAC_free(mac); // the context holds its own reference
+				if (!c) return c;
+				OSSL_PARAM params[] = {
+					OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, const_cast<char*>(EVP_MD_get0_name(md)), 0),
+					OSSL_PARAM_construct_end()};
+				if (EVP_MAC_init(c.get(), reinterpret_cast<const unsigned char*>(key.data()), key.size(), params) != 1)
+					c.reset();
+#else
+#ifdef JWT_OPENSSL_1_0_0
+				c.reset(new HMAC_CTX);
+				HMAC_CTX_init(c.get());
+#else
+				c.reset(HMAC_CTX_new());
+				if (!c) return c;
+#endif
+				if (HMAC_Init_ex(c.get(), key.data(), static_cast<int>(key.size()), md, nullptr) != 1) c.reset();
+#endif
+				return c;
+			}
+
+			const EVP_MD* md;
+			std::string key;
+			std::unique_ptr<context, void (*)(context*)> ctx;
+		};
+
+		/**
+		 * \brief The calling thread's keyed HMAC context for a hash function and key
+		 *
+		 * Contexts are created on first use and kept per thread, so they are never shared
+		 * between threads and need no locking. Only the few most recently used keys are
+		 * kept: a hit moves its context to the back, and a new key evicts the front.
+		 * The reference is only valid until the thread's next call.
+		 */
+		inline const keyed_hmac& thread_keyed_hmac(const EVP_MD* md, const std::string& key) {
+			static constexpr size_t max_keys = 4;
+			thread_local std::vector<keyed_hmac> contexts;
+			for (auto it = contexts.begin(); it != contexts.end(); ++it) {
+				if (it->matches(md, key)) {
+					std::rotate(it, it + 1, contexts.end());
+					return contexts.back();
+				}
+			}
+			if (contexts.size() >= max_keys) contexts.erase(contexts.begin());
+			contexts.emplace_back(md, key);
+			return contexts.back();
+		}
+
 		/**
 		 * \brief Extract the public key of a pem certificate
 		 *
@@ -1368,6 +1505,9 @@ namespace jwt {
 		};
 		/**
 		 * \brief Base class for HMAC family of algorithms
+		 *
+		 * Signing and verifying use the calling thread's context for this key (see
+		 * helper::thread_keyed_hmac), so the key schedule is only computed once per thread.
 		 */
 		struct hmacsha {
 			/**
@@ -1388,17 +1528,13 @@ namespace jwt {
 			 */
 			std::string sign(const std::string& data, std::error_code& ec) const {
 				ec.clear();
-				std::string res(static_cast<size_t>(EVP_MAX_MD_SIZE), '\0');
-				auto len = static_cast<unsigned int>(res.size());
-				if (HMAC(md(), secret.data(), static_cast<int>(secret.size()),
-						 reinterpret_cast<const unsigned char*>(data.data()), static_cast<int>(data.size()),
-						 (unsigned char*)res.data(), // NOLINT(google-readability-casting) requires `const_cast`
-						 &len) == nullptr) {
+				unsigned char res[EVP_MAX_MD_SIZE];
+				size_t len = 0;
+				if (!helper::thread_keyed_hmac(md(), secret).compute(data, res, len)) {
 					ec = error::signature_generation_error::hmac_failed;
 					return {};
 				}
-				res.resize(len);
-				return res;
+				return std::string(reinterpret_cast<const char*>(res), len);
 			}
 			/**
 			 * Check if signature is valid
@@ -1408,19 +1544,20 @@ namespace jwt {
 			 * \param ec Filled with details about failure.
 			 */
 			void verify(const std::string& data, const std::string& signature, std::error_code& ec) const {
-				ec.clear();
-				auto res = sign(data, ec);
-				if (ec) return;
-
-				bool matched = true;
-				for (size_t i = 0; i < std::min<size_t>(res.size(), signature.size()); i++)
-					if (res[i] != signature[i]) matched = false;
-				if (res.size() != signature.size()) matched = false;
-				if (!matched) {
-					ec = error::signature_verification_error::invalid_signature;
-					return;
-				}
+				verify(data.data(), data.size(), signature.data(), signature.size(), ec);
 			}
+#ifdef JWT_HAS_STRING_VIEW
+			/**
+			 * Check if signature is valid, without copying either argument
+			 *
+			 * \param data The data to check signature against
+			 * \param signature Signature provided by the jwt
+			 * \param ec Filled with details about failure.
+			 */
+			void verify(std::string_view data, std::string_view signature, std::error_code& ec) const {
+				verify(data.data(), data.size(), signature.data(), signature.size(), ec);
+			}
+#endif
 			/**
 			 * Returns the algorithm name provided to the constructor
 			 *
@@ -1429,6 +1566,23 @@ namespace jwt {
 			std::string name() const { return alg_name; }
 
 		private:
+			void verify(const char* data, size_t size, const char* signature, size_t signature_size,
+						std::error_code& ec) const {
+				ec.clear();
+				unsigned char res[EVP_MAX_MD_SIZE];
+				size_t len = 0;
+				if (!helper::thread_keyed_hmac(md(), secret).compute(data, size, res, len)) {
+					ec = error::signature_generation_error::hmac_failed;
+					return;
+				}
+
+				// Constant time for a signature of the right length; the length is public
+				if (signature_size != len || CRYPTO_memcmp(res, signature, len) != 0) {
+					ec = error::signature_verification_error::invalid_signature;
+					return;
+				}
+			}
+
 			/// HMAC secret
 			const std::string secret;
 			/// HMAC hash generator
@@ -3081,6 +3235,356 @@ namespace jwt {
 		}
 	};
 
+#if defined(JWT_HAS_STRING_VIEW) && !defined(JWT_DISABLE_BASE64)
+	/**
+	 * \brief A token parsed without copying it or building claim maps
+	 *
+	 * The three parts are split as views of the token and decoded into a buffer owned by
+	 * the calling thread, which keeps its capacity between tokens. Only the `alg` header
+	 * and the `iss`, `sub` and `exp` claims are located in the JSON; everything else is
+	 * skipped without being parsed, so use decoded_jwt when other claims are needed.
+	 *
+	 * \warning The views point into the token and into the thread's buffer: the token must
+	 * outlive this object, and this object is invalidated by the next decoded_jwt_view
+	 * constructed on the same thread.
+	 */
+	class decoded_jwt_view {
+	public:
+		/**
+		 * \brief Parses a given token
+		 *
+		 * \param token The token to parse
+		 * \throw std::invalid_argument Token is not in correct format
+		 * \throw std::runtime_error Base64 decoding failed, invalid json or a duplicated claim
+		 */
+		explicit decoded_jwt_view(std::string_view token) : token(token) {
+			auto hdr_end = token.find('.');
+			if (hdr_end == std::string_view::npos) throw std::invalid_argument("invalid token supplied");
+			auto payload_end = token.find('.', hdr_end + 1);
+			if (payload_end == std::string_view::npos) throw std::invalid_argument("invalid token supplied");
+			header_base64 = token.substr(0, hdr_end);
+			payload_base64 = token.substr(hdr_end + 1, payload_end - hdr_end - 1);
+			signature_base64 = token.substr(payload_end + 1);
+
+			std::string& buffer = thread_buffer();
+			buffer.clear();
+			base::decode_into<alphabet::base64url>(header_base64, buffer);
+			const size_t header_size = buffer.size();
+			base::decode_into<alphabet::base64url>(payload_base64, buffer);
+			const size_t payload_size = buffer.size() - header_size;
+			base::decode_into<alphabet::base64url>(signature_base64, buffer);
+
+			// Only take views once the buffer has its final size
+			std::string_view decoded(buffer);
+			header = decoded.substr(0, header_size);
+			payload = decoded.substr(header_size, payload_size);
+			signature = decoded.substr(header_size + payload_size);
+
+			const std::string_view header_names[] = {"alg"};
+			find_members(header, header_names, &algorithm_claim, 1);
+			const std::string_view payload_names[] = {"iss", "sub", "exp"};
+			std::string_view payload_values[3];
+			find_members(payload, payload_names, payload_values, 3);
+			issuer_claim = payload_values[0];
+			subject_claim = payload_values[1];
+			expires_at_claim = payload_values[2];
+		}
+
+		/// Get token as passed to constructor
+		std::string_view get_token() const noexcept { return token; }
+		/// Get header part after base64 decoding
+		std::string_view get_header() const noexcept { return header; }
+		/// Get payload part after base64 decoding
+		std::string_view get_payload() const noexcept { return payload; }
+		/// Get signature part after base64 decoding
+		std::string_view get_signature() const noexcept { return signature; }
+		/// Get header part before base64 decoding
+		std::string_view get_header_base64() const noexcept { return header_base64; }
+		/// Get payload part before base64 decoding
+		std::string_view get_payload_base64() const noexcept { return payload_base64; }
+		/// Get signature part before base64 decoding
+		std::string_view get_signature_base64() const noexcept { return signature_base64; }
+		/// Get the data the signature covers, the header and payload in base64 joined by a dot
+		std::string_view get_signed_data() const noexcept {
+			return token.substr(0, header_base64.size() + 1 + payload_base64.size());
+		}
+
+		/// Check if the algorithm ("alg") header is present
+		bool has_algorithm() const noexcept { return !algorithm_claim.empty(); }
+		/// Check if the issuer ("iss") claim is present
+		bool has_issuer() const noexcept { return !issuer_claim.empty(); }
+		/// Check if the subject ("sub") claim is present
+		bool has_subject() const noexcept { return !subject_claim.empty(); }
+		/// Check if the expires ("exp") claim is present
+		bool has_expires_at() const noexcept { return !expires_at_claim.empty(); }
+
+		/**
+		 * Get algorithm claim
+		 * \return algorithm as string
+		 * \throw jwt::error::claim_not_present_exception If claim was not present
+		 * \throw std::bad_cast Claim was present but not a string
+		 */
+		std::string get_algorithm() const { return as_string(algorithm_claim); }
+		/**
+		 * Get issuer claim
+		 * \return issuer as string
+		 * \throw jwt::error::claim_not_present_exception If claim was not present
+		 * \throw std::bad_cast Claim was present but not a string
+		 */
+		std::string get_issuer() const { return as_string(issuer_claim); }
+		/**
+		 * Get subject claim
+		 * \return subject as string
+		 * \throw jwt::error::claim_not_present_exception If claim was not present
+		 * \throw std::bad_cast Claim was present but not a string
+		 */
+		std::string get_subject() const { return as_string(subject_claim); }
+		/**
+		 * Get expires claim
+		 * \return expires as a date in utc
+		 * \throw jwt::error::claim_not_present_exception If claim was not present
+		 * \throw std::bad_cast Claim was present but not a number
+		 */
+		date get_expires_at() const { return as_date(expires_at_claim); }
+
+		/**
+		 * Verify the signature with an HMAC algorithm, which must be the one named by the
+		 * algorithm header
+		 *
+		 * \param alg Algorithm the token has to be signed with
+		 * \param ec Filled with details about failure.
+		 */
+		void verify(const algorithm::hmacsha& alg, std::error_code& ec) const {
+			ec.clear();
+			if (!has_algorithm() || as_string(algorithm_claim) != alg.name()) {
+				ec = error::token_verification_error::wrong_algorithm;
+				return;
+			}
+			alg.verify(get_signed_data(), signature, ec);
+		}
+
+	private:
+		static std::string& thread_buffer() {
+			thread_local std::string buffer;
+			return buffer;
+		}
+
+		static void skip_whitespace(std::string_view json, size_t& i) {
+			while (i < json.size() && (json[i] == ' ' || json[i] == '\t' || json[i] == '\n' || json[i] == '\r'))
+				++i;
+		}
+
+		static void expect(std::string_view json, size_t& i, char c) {
+			if (i >= json.size() || json[i] != c) throw error::invalid_json_exception();
+			++i;
+		}
+
+		// Advances past a string, returning it with its quotes
+		static std::string_view scan_string(std::string_view json, size_t& i) {
+			const size_t start = i;
+			expect(json, i, '"');
+			while (i < json.size()) {
+				const char c = json[i];
+				if (c == '"') return json.substr(start, ++i - start);
+				if (static_cast<unsigned char>(c) < 0x20) break;
+				i += c == '\\' ? 2 : 1;
+			}
+			throw error::invalid_json_exception();
+		}
+
+		// Advances past any value, only checking that brackets and strings are closed
+		static std::string_view scan_value(std::string_view json, size_t& i) {
+			const size_t start = i;
+			if (i >= json.size()) throw error::invalid_json_exception();
+			if (json[i] == '"') return scan_string(json, i);
+			if (json[i] == '{' || json[i] == '[') {
+				size_t depth = 0;
+				do {
+					if (i >= json.size()) throw error::invalid_json_exception();
+					const char c = json[i];
+					if (c == '"') {
+						scan_string(json, i);
+						continue;
+					}
+					if (c == '{' || c == '[')
+						++depth;
+					else if (c == '}' || c == ']')
+						--depth;
+					++i;
+				} while (depth != 0);
+				return json.substr(start, i - start);
+			}
+			while (i < json.size() && std::strchr(",}] \t\n\r", json[i]) == nullptr)
+				++i;
+			if (i == start) throw error::invalid_json_exception();
+			return json.substr(start, i - start);
+		}
+
+		// Finds the raw values of the named members of a JSON object; absent ones stay empty
+		static void find_members(std::string_view json, const std::string_view* names, std::string_view* values,
+								 size_t count) {
+			size_t i = 0;
+			skip_whitespace(json, i);
+			expect(json, i, '{');
+			skip_whitespace(json, i);
+			if (i < json.size() && json[i] == '}') {
+				++i;
+			} else {
+				while (true) {
+					const std::string_view key = scan_string(json, i);
+					skip_whitespace(json, i);
+					expect(json, i, ':');
+					skip_whitespace(json, i);
+					const std::string_view value = scan_value(json, i);
+
+					std::string unescaped;
+					std::string_view name = key.substr(1, key.size() - 2);
+					if (name.find('\\') != std::string_view::npos) {
+						unescaped = unescape(name);
+						name = unescaped;
+					}
+					for (size_t n = 0; n < count; ++n) {
+						if (name != names[n]) continue;
+						// Different parsers would pick different duplicates, so reject them
+						if (!values[n].empty()) throw std::runtime_error("duplicate claim");
+						values[n] = value;
+					}
+
+					skip_whitespace(json, i);
+					if (i < json.size() && json[i] == ',') {
+						++i;
+						skip_whitespace(json, i);
+						continue;
+					}
+					expect(json, i, '}');
+					break;
+				}
+			}
+			skip_whitespace(json, i);
+			if (i != json.size()) throw error::invalid_json_exception();
+		}
+
+		static void append_utf8(std::string& out, uint32_t cp) {
+			if (cp < 0x80) {
+				out += static_cast<char>(cp);
+			} else if (cp < 0x800) {
+				out += static_cast<char>(0xC0 | (cp >> 6));
+				out += static_cast<char>(0x80 | (cp & 0x3F));
+			} else if (cp < 0x10000) {
+				out += static_cast<char>(0xE0 | (cp >> 12));
+				out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+				out += static_cast<char>(0x80 | (cp & 0x3F));
+			} else {
+				out += static_cast<char>(0xF0 | (cp >> 18));
+				out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+				out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+				out += static_cast<char>(0x80 | (cp & 0x3F));
+			}
+		}
+
+		static uint32_t read_hex4(std::string_view s, size_t i) {
+			if (i + 4 > s.size()) throw error::invalid_json_exception();
+			uint32_t cp = 0;
+			for (size_t end = i + 4; i < end; ++i) {
+				const char c = s[i];
+				cp <<= 4;
+				if (c >= '0' && c <= '9')
+					cp |= static_cast<uint32_t>(c - '0');
+				else if (c >= 'a' && c <= 'f')
+					cp |= static_cast<uint32_t>(c - 'a' + 10);
+				else if (c >= 'A' && c <= 'F')
+					cp |= static_cast<uint32_t>(c - 'A' + 10);
+				else
+					throw error::invalid_json_exception();
+			}
+			return cp;
+		}
+
+		// Resolves the escapes of a JSON string's contents
+		static std::string unescape(std::string_view s) {
+			std::string out;
+			out.reserve(s.size());
+			for (size_t i = 0; i < s.size(); ++i) {
+				if (s[i] != '\\') {
+					out += s[i];
+					continue;
+				}
+				if (++i >= s.size()) throw error::invalid_json_exception();
+				switch (s[i]) {
+				case '"': out += '"'; break;
+				case '\\': out += '\\'; break;
+				case '/': out += '/'; break;
+				case 'b': out += '\b'; break;
+				case 'f': out += '\f'; break;
+				case 'n': out += '\n'; break;
+				case 'r': out += '\r'; break;
+				case 't': out += '\t'; break;
+				case 'u': {
+					uint32_t cp = read_hex4(s, i + 1);
+					i += 4;
+					if (cp >= 0xD800 && cp <= 0xDBFF) {
+						if (i + 2 >= s.size() || s[i + 1] != '\\' || s[i + 2] != 'u')
+							throw error::invalid_json_exception();
+						const uint32_t low = read_hex4(s, i + 3);
+						if (low < 0xDC00 || low > 0xDFFF) throw error::invalid_json_exception();
+						cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+						i += 6;
+					} else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+						throw error::invalid_json_exception();
+					}
+					append_utf8(out, cp);
+					break;
+				}
+				default: throw error::invalid_json_exception();
+				}
+			}
+			return out;
+		}
+
+		static std::string as_string(std::string_view raw) {
+			if (raw.empty()) throw error::claim_not_present_exception();
+			if (raw.front() != '"') throw std::bad_cast();
+			const std::string_view s = raw.substr(1, raw.size() - 2);
+			if (s.find('\\') == std::string_view::npos) return std::string(s);
+			return unescape(s);
+		}
+
+		static date as_date(std::string_view raw) {
+			using std::chrono::system_clock;
+			if (raw.empty()) throw error::claim_not_present_exception();
+			size_t i = raw.front() == '-' ? 1 : 0;
+			if (i == raw.size()) throw std::bad_cast();
+			std::time_t value = 0;
+			for (; i < raw.size(); ++i) {
+				if (raw[i] < '0' || raw[i] > '9') break;
+				if (value > (std::numeric_limits<std::time_t>::max() - 9) / 10) throw std::bad_cast();
+				value = value * 10 + (raw[i] - '0');
+			}
+			if (i == raw.size()) return system_clock::from_time_t(raw.front() == '-' ? -value : value);
+
+			// A fraction or exponent: rounded like basic_claim::as_date
+			const std::string number(raw);
+			char* end = nullptr;
+			const double d = std::strtod(number.c_str(), &end);
+			if (end != number.c_str() + number.size() || !std::isfinite(d)) throw std::bad_cast();
+			return system_clock::from_time_t(static_cast<std::time_t>(std::round(d)));
+		}
+
+		std::string_view token;
+		std::string_view header;
+		std::string_view header_base64;
+		std::string_view payload;
+		std::string_view payload_base64;
+		std::string_view signature;
+		std::string_view signature_base64;
+		/// Raw JSON values of the claims that are read, empty when absent
+		std::string_view algorithm_claim;
+		std::string_view issuer_claim;
+		std::string_view subject_claim;
+		std::string_view expires_at_claim;
+	};
+#endif
+
 	/**
 	 * Builder class to build and sign a new token
 	 * Use jwt::create() to get an instance of this class.
@@ -4185,6 +4689,18 @@ namespace jwt {
 	decoded_jwt<json_traits> decode(const typename json_traits::string_type& token) {
 		return decoded_jwt<json_traits>(token);
 	}
+#if defined(JWT_HAS_STRING_VIEW) && !defined(JWT_DISABLE_BASE64)
+	/**
+	 * Decode a token without copying it, for when only the algorithm, issuer, subject
+	 * and expiry are needed. See decoded_jwt_view for how long the result stays valid.
+	 *
+	 * \param token Token to decode
+	 * \return Decoded token
+	 * \throw std::invalid_argument Token is not in correct format
+	 * \throw std::runtime_error Base64 decoding failed or invalid json
+	 */
+	inline decoded_jwt_view decode_view(std::string_view token) { return decoded_jwt_view(token); }
+#endif
 	/**
 	 * Parse a single JSON Web Key
 	 * \tparam json_traits JSON implementation traits
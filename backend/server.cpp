@@ -1,6 +1,7 @@
 #include <crow.h>
 #include <iostream>
 #include <vector>
+#include <memory>
 #include <string>
 #include <sqlite3.h>
 #include <nlohmann/json.hpp>
@@ -9,333 +10,3916 @@
 #include <queue>
 #include <condition_variable>
 #include <unordered_map>
+#include <shared_mutex>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
 #include <ctime>
+#include <atomic>
+#include <cstdlib>
+#include <future>
+#include <stdexcept>
+#include <type_traits>
+#include <deque>
+#include <tuple>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cctype>
+#include <fstream>
+#include <optional>
+#include <array>
+#include <random>
+#include <limits>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
 #include "jwt-cpp/jwt.h" // For JWT token handling
+#include <openssl/evp.h>
+#include <openssl/rand.h>
 
 using json = nlohmann::json;
-sqlite3 *db;
-std::mutex db_mutex;
-std::queue<std::function<void()>> task_queue;
-std::condition_variable cv;
-bool running = true;
-std::unordered_map<std::string, std::string> active_sessions; // Active JWT sessions
+
+// --------------------------------------------------------------------------------
+// Prepared-statement cache. Every connection keeps the statements it has compiled,
+// keyed by their SQL text, and hands them out again after a reset instead of
+// re-parsing and re-planning the SQL on every request.
+// --------------------------------------------------------------------------------
+std::atomic<unsigned long long> stmt_cache_hits{0};
+std::atomic<unsigned long long> stmt_cache_misses{0};
+
+// A statement borrowed from a connection's cache. It is reset and its bindings are
+// cleared when it goes out of scope, so it is ready for the next user and does not
+// keep a read transaction open.
+class CachedStatement
+{
+public:
+    explicit CachedStatement(sqlite3_stmt *stmt = nullptr) : stmt_(stmt) {}
+    CachedStatement(const CachedStatement &) = delete;
+    CachedStatement &operator=(const CachedStatement &) = delete;
+    CachedStatement(CachedStatement &&other) noexcept : stmt_(other.stmt_) { other.stmt_ = nullptr; }
+    ~CachedStatement()
+    {
+        if (stmt_)
+        {
+            sqlite3_reset(stmt_);
+            sqlite3_clear_bindings(stmt_);
+        }
+    }
+
+    sqlite3_stmt *get() const { return stmt_; }
+    explicit operator bool() const { return stmt_ != nullptr; }
+
+private:
+    sqlite3_stmt *stmt_;
+};
+
+class DbConnection
+{
+public:
+    bool open(const char *path, int flags)
+    {
+        return sqlite3_open_v2(path, &handle_, flags, nullptr) == SQLITE_OK;
+    }
+
+    void close()
+    {
+        for (auto &entry : statements_)
+        {
+            sqlite3_finalize(entry.second);
+        }
+        statements_.clear();
+        sqlite3_close(handle_);
+        handle_ = nullptr;
+    }
+
+    sqlite3 *handle() const { return handle_; }
+
+    // Returns the cached statement for this SQL, compiling it on first use.
+    // The caller must hold whatever lock guards this connection.
+    CachedStatement prepare(const char *sql)
+    {
+        auto it = statements_.find(sql);
+        if (it != statements_.end())
+        {
+            stmt_cache_hits.fetch_add(1, std::memory_order_relaxed);
+            return CachedStatement(it->second);
+        }
+
+        stmt_cache_misses.fetch_add(1, std::memory_order_relaxed);
+        sqlite3_stmt *stmt = nullptr;
+        if (sqlite3_prepare_v3(handle_, sql, -1, SQLITE_PREPARE_PERSISTENT, &stmt, nullptr) != SQLITE_OK)
+        {
+            std::cerr << "SQL prepare error: " << sqlite3_errmsg(handle_) << "\n";
+            sqlite3_finalize(stmt);
+            return CachedStatement();
+        }
+        statements_.emplace(sql, stmt);
+        return CachedStatement(stmt);
+    }
+
+private:
+    sqlite3 *handle_ = nullptr;
+    std::unordered_map<std::string, sqlite3_stmt *> statements_;
+};
+
+// --------------------------------------------------------------------------------
+// Runtime configuration. Every setting is declared below with its default and can
+// be overridden, in increasing order of precedence, by a config file (--config=PATH
+// or AUCTION_CONFIG; "name = value" lines, # comments), by the environment
+// (AUCTION_<NAME>, e.g. AUCTION_DB_PATH) and by flags (--name=value, dashes or
+// underscores). Unknown names in the file or flags are an error.
+// --------------------------------------------------------------------------------
+class Config
+{
+public:
+    enum class Kind
+    {
+        Int,
+        String,
+        CpuList, // e.g. "0-3,8"; empty means no affinity
+        Secret   // a string that is never printed
+    };
+
+    // An Int setting outside [min, max] is rejected by load()
+    void define(const char *name, Kind kind, std::string fallback, const char *help,
+                long long min = std::numeric_limits<long long>::min(),
+                long long max = std::numeric_limits<long long>::max())
+    {
+        index_[name] = settings_.size();
+        settings_.push_back(Setting{name, kind, std::move(fallback), "default", help, min, max});
+    }
+
+    // Applies the file, the environment and the flags; false if any of them is invalid
+    bool load(int argc, char **argv)
+    {
+        std::string file = envValue("config");
+        std::vector<std::pair<std::string, std::string>> flags;
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            size_t eq = arg.find('=');
+            if (arg.compare(0, 2, "--") != 0 || eq == std::string::npos)
+            {
+                std::cerr << "Invalid argument " << arg << " (expected --name=value)\n";
+                return false;
+            }
+            std::string name = normalize(arg.substr(2, eq - 2));
+            if (name == "config")
+            {
+                file = arg.substr(eq + 1);
+            }
+            else
+            {
+                flags.emplace_back(name, arg.substr(eq + 1));
+            }
+        }
+
+        bool ok = file.empty() || loadFile(file);
+        for (auto &setting : settings_)
+        {
+            std::string value = envValue(setting.name);
+            if (!value.empty())
+            {
+                ok = set(setting.name, value, "env") && ok;
+            }
+        }
+        for (const auto &flag : flags)
+        {
+            ok = set(flag.first, flag.second, "flag") && ok;
+        }
+        return ok;
+    }
+
+    const std::string &getString(const std::string &name) const
+    {
+        return find(name).value;
+    }
+
+    long long getInt(const std::string &name) const
+    {
+        return std::stoll(find(name).value);
+    }
+
+    // CPU ids of a CpuList setting
+    std::vector<int> getCpus(const std::string &name) const
+    {
+        std::vector<int> cpus;
+        parseCpuList(find(name).value, cpus);
+        return cpus;
+    }
+
+    // Prints the effective configuration and where each value came from
+    void print(std::ostream &out) const
+    {
+        out << "Configuration:\n";
+        for (const auto &setting : settings_)
+        {
+            const std::string &shown = setting.kind == Kind::Secret ? std::string("********") : setting.value;
+            out << "  " << std::left << std::setw(24) << setting.name << " = " << (shown.empty() ? "(none)" : shown)
+                << " [" << setting.source << "]\n";
+        }
+    }
+
+    void printHelp(std::ostream &out) const
+    {
+        out << "Settings (--name=value, AUCTION_<NAME>, or a --config file):\n";
+        for (const auto &setting : settings_)
+        {
+            out << "  " << std::left << std::setw(24) << setting.name << " " << setting.help << "\n";
+        }
+    }
+
+private:
+    struct Setting
+    {
+        std::string name;
+        Kind kind;
+        std::string value;
+        const char *source;
+        const char *help;
+        long long min;
+        long long max;
+    };
+
+    static std::string normalize(std::string name)
+    {
+        std::replace(name.begin(), name.end(), '-', '_');
+        std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c)
+                       { return static_cast<char>(std::tolower(c)); });
+        return name;
+    }
+
+    static std::string envValue(const std::string &name)
+    {
+        std::string env = "AUCTION_" + name;
+        std::transform(env.begin(), env.end(), env.begin(), [](unsigned char c)
+                       { return static_cast<char>(std::toupper(c)); });
+        const char *value = std::getenv(env.c_str());
+        return value ? value : "";
+    }
+
+    static std::string trim(const std::string &text)
+    {
+        size_t begin = text.find_first_not_of(" \t\r");
+        size_t end   = text.find_last_not_of(" \t\r");
+        return begin == std::string::npos ? "" : text.substr(begin, end - begin + 1);
+    }
+
+    bool loadFile(const std::string &path)
+    {
+        std::ifstream in(path);
+        if (!in)
+        {
+            std::cerr << "Can't read config file " << path << "\n";
+            return false;
+        }
+        bool ok = true;
+        std::string line;
+        for (int number = 1; std::getline(in, line); ++number)
+        {
+            line = trim(line.substr(0, line.find('#')));
+            if (line.empty())
+            {
+                continue;
+            }
+            size_t eq = line.find('=');
+            if (eq == std::string::npos)
+            {
+                std::cerr << path << ":" << number << ": expected name = value\n";
+                ok = false;
+                continue;
+            }
+            ok = set(normalize(trim(line.substr(0, eq))), trim(line.substr(eq + 1)), "file") && ok;
+        }
+        return ok;
+    }
+
+    bool set(const std::string &name, const std::string &value, const char *source)
+    {
+        auto it = index_.find(name);
+        if (it == index_.end())
+        {
+            std::cerr << "Unknown setting " << name << " (" << source << ")\n";
+            return false;
+        }
+        Setting &setting = settings_[it->second];
+        bool valid = true;
+        if (setting.kind == Kind::Int)
+        {
+            try
+            {
+                size_t used = 0;
+                long long number = std::stoll(value, &used);
+                valid = used == value.size();
+                if (valid && (number < setting.min || number > setting.max))
+                {
+                    std::cerr << "Value for " << name << " (" << source << ") must be between "
+                              << setting.min << " and " << setting.max << ": " << value << "\n";
+                    return false;
+                }
+            }
+            catch (const std::exception &)
+            {
+                valid = false;
+            }
+        }
+        else if (setting.kind == Kind::CpuList)
+        {
+            std::vector<int> cpus;
+            valid = parseCpuList(value, cpus);
+        }
+        if (!valid)
+        {
+            std::cerr << "Invalid value for " << name << " (" << source << "): " << value << "\n";
+            return false;
+        }
+        setting.value  = value;
+        setting.source = source;
+        return true;
+    }
+
+    const Setting &find(const std::string &name) const
+    {
+        return settings_.at(index_.at(name));
+    }
+
+    static bool parseCpuList(const std::string &list, std::vector<int> &cpus)
+    {
+        std::stringstream ss(list);
+        std::string part;
+        while (std::getline(ss, part, ','))
+        {
+            part = trim(part);
+            if (part.empty())
+            {
+                continue;
+            }
+            try
+            {
+                size_t dash = part.find('-');
+                int first   = std::stoi(part.substr(0, dash));
+                int last    = dash == std::string::npos ? first : std::stoi(part.substr(dash + 1));
+                if (first < 0 || last < first)
+                {
+                    return false;
+                }
+                for (int cpu = first; cpu <= last; ++cpu)
+                {
+                    cpus.push_back(cpu);
+                }
+            }
+            catch (const std::exception &)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::vector<Setting> settings_;
+    std::unordered_map<std::string, size_t> index_;
+};
+
+// Every setting the server reads, with its default
+Config makeConfig()
+{
+    const std::string cores = std::to_string(std::max(1u, std::thread::hardware_concurrency()));
+    using Kind = Config::Kind;
+    // Upper bounds, so that a typo is refused rather than wrapped by a narrowing cast
+    // or turned into a huge allocation
+    const long long MAX_THREADS = 4096;
+    const long long MAX_QUEUE   = 1 << 24;
+    const long long MIN_INT     = std::numeric_limits<int>::min();
+    const long long MAX_INT     = std::numeric_limits<int>::max();
+    const long long MAX_LONG    = std::numeric_limits<long long>::max();
+    Config config;
+    config.define("bind_address", Kind::String, "0.0.0.0", "address to listen on");
+    config.define("port", Kind::Int, "8080", "port to listen on", 1, 65535);
+    config.define("crow_threads", Kind::Int, cores, "HTTP I/O threads", 1, MAX_THREADS);
+    config.define("crow_cpus", Kind::CpuList, "", "CPUs for the HTTP I/O threads");
+    config.define("jwt_secret", Kind::Secret, "secret", "HMAC key that signs session tokens");
+    config.define("db_path", Kind::String, "auction.db", "SQLite database file");
+    config.define("db_readers", Kind::Int, std::to_string(std::max(2u, std::thread::hardware_concurrency())), "reader connections", 1, MAX_THREADS);
+    config.define("db_synchronous", Kind::String, "NORMAL", "PRAGMA synchronous: OFF, NORMAL, FULL or EXTRA");
+    config.define("db_cache_size", Kind::Int, "-16000", "PRAGMA cache_size: pages, or KiB when negative", MIN_INT, MAX_INT);
+    config.define("db_mmap_size", Kind::Int, "0", "PRAGMA mmap_size in bytes, 0 disables", 0, MAX_LONG);
+    config.define("db_busy_timeout_ms", Kind::Int, "5000", "PRAGMA busy_timeout", 0, MAX_INT);
+    config.define("commit_window_us", Kind::Int, "500", "group-commit gathering window", 0, 1000000);
+    config.define("commit_max_batch", Kind::Int, "128", "writes per group commit", 1, MAX_QUEUE);
+    config.define("commit_cpus", Kind::CpuList, "", "CPUs for the commit, closer and sweeper threads");
+    config.define("bid_shards", Kind::Int, cores, "bid shard threads", 1, MAX_THREADS);
+    config.define("bid_mailbox", Kind::Int, "4096", "commands queued per shard before bids are shed", 2, MAX_QUEUE);
+    config.define("shard_cpus", Kind::CpuList, "", "CPUs for the bid shard threads");
+    config.define("workers", Kind::Int, cores, "task executor threads", 1, MAX_THREADS);
+    config.define("worker_queue", Kind::Int, "1024", "tasks queued before requests are shed", 1, MAX_QUEUE);
+    config.define("worker_cpus", Kind::CpuList, "", "CPUs for the task executor threads");
+    config.define("hash_workers", Kind::Int, std::to_string(std::max(1u, std::thread::hardware_concurrency() / 2)), "password hashing threads", 1, MAX_THREADS);
+    config.define("hash_queue", Kind::Int, "256", "password hashes queued before logins are shed", 1, MAX_QUEUE);
+    config.define("hash_cpus", Kind::CpuList, "", "CPUs for the password hashing threads");
+    config.define("pbkdf2_iterations", Kind::Int, "100000", "PBKDF2-HMAC-SHA256 iterations for new password hashes", 1, 100000000);
+    config.define("response_cache_entries", Kind::Int, "4096", "cached listing responses", 1, MAX_QUEUE);
+    config.define("session_sweep_s", Kind::Int, "60", "interval between expired session sweeps", 1, 86400);
+    config.define("session_jitter_s", Kind::Int, "300", "up to this much is taken off each token's lifetime, to spread out expiries", 0, 86400);
+    config.define("token_cache_entries", Kind::Int, "65536", "verified tokens cached", 1, MAX_QUEUE);
+    config.define("auth_tokens", Kind::String, "jwt", "what /login issues: jwt, or opaque session ids");
+    config.define("opaque_sessions", Kind::Int, "65536", "opaque session ids held at once", 1, MAX_QUEUE);
+    config.define("admit_bid_limit", Kind::Int, "4096", "bid requests in flight", 1, MAX_QUEUE);
+    config.define("admit_auth_limit", Kind::Int, "256", "auth requests in flight", 1, MAX_QUEUE);
+    config.define("admit_read_limit", Kind::Int, "512", "read requests in flight", 1, MAX_QUEUE);
+    config.define("bid_p99_target_ms", Kind::Int, "100", "bid latency above which reads are shed", 1, 3600000);
+    config.define("admit_window_ms", Kind::Int, "1000", "latency measurement window", 10, 3600000);
+    return config;
+}
+
+Config config = makeConfig();
+
+// Pins the calling thread to the given CPUs (threads it creates inherit the set);
+// does nothing for an empty list
+void pinCurrentThread(const std::vector<int> &cpus)
+{
+#ifdef __linux__
+    if (cpus.empty())
+    {
+        return;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus)
+    {
+        if (cpu < CPU_SETSIZE)
+        {
+            CPU_SET(cpu, &set);
+        }
+    }
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (rc != 0)
+    {
+        std::cerr << "Can't set CPU affinity: " << std::strerror(rc) << "\n";
+    }
+#else
+    (void)cpus;
+#endif
+}
+
+// --------------------------------------------------------------------------------
+// Connection pool: one writer connection and N reader connections, all in WAL mode
+// so readers never block behind the writer (or each other).
+// --------------------------------------------------------------------------------
+struct DbOptions
+{
+    std::string path;
+    int readers;
+    std::string synchronous; // OFF, NORMAL, FULL or EXTRA
+    int cache_size;          // pages, or KiB when negative (SQLite semantics)
+    long long mmap_size;     // bytes, 0 disables memory-mapped I/O
+    int busy_timeout_ms;
+};
+
+DbOptions dbOptionsFromConfig(const Config &config)
+{
+    DbOptions options;
+    options.path            = config.getString("db_path");
+    options.readers         = static_cast<int>(config.getInt("db_readers"));
+    options.synchronous     = config.getString("db_synchronous");
+    options.cache_size      = static_cast<int>(config.getInt("db_cache_size"));
+    options.mmap_size       = config.getInt("db_mmap_size");
+    options.busy_timeout_ms = static_cast<int>(config.getInt("db_busy_timeout_ms"));
+    return options;
+}
+
+class ConnectionPool
+{
+public:
+    // A connection checked out of the pool; it goes back when the lease is destroyed
+    class Lease
+    {
+    public:
+        Lease(ConnectionPool *pool, DbConnection *conn, std::unique_lock<std::mutex> writer_lock)
+            : pool_(pool), conn_(conn), writer_lock_(std::move(writer_lock)) {}
+        Lease(const Lease &) = delete;
+        Lease &operator=(const Lease &) = delete;
+        Lease(Lease &&other) noexcept
+            : pool_(other.pool_), conn_(other.conn_), writer_lock_(std::move(other.writer_lock_))
+        {
+            other.conn_ = nullptr;
+        }
+        ~Lease()
+        {
+            if (conn_ && !writer_lock_.owns_lock())
+            {
+                pool_->releaseReader(conn_);
+            }
+        }
+
+        DbConnection *operator->() const { return conn_; }
+        DbConnection &operator*() const { return *conn_; }
+
+    private:
+        ConnectionPool *pool_;
+        DbConnection *conn_;
+        std::unique_lock<std::mutex> writer_lock_;
+    };
+
+    bool open(const DbOptions &options)
+    {
+        // The writer goes first: it creates the file and switches it to WAL mode
+        if (!openConnection(writer_, options, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE) ||
+            !exec(writer_, "PRAGMA journal_mode=WAL;"))
+        {
+            return false;
+        }
+
+        readers_.resize(options.readers);
+        for (auto &reader : readers_)
+        {
+            if (!openConnection(reader, options, SQLITE_OPEN_READWRITE))
+            {
+                return false;
+            }
+            idle_readers_.push_back(&reader);
+        }
+        return true;
+    }
+
+    void close()
+    {
+        for (auto &reader : readers_)
+        {
+            reader.close();
+        }
+        readers_.clear();
+        idle_readers_.clear();
+        writer_.close();
+    }
+
+    // Exclusive access to the single writer connection
+    Lease writer()
+    {
+        return Lease(this, &writer_, std::unique_lock<std::mutex>(writer_mutex_));
+    }
+
+    // Any idle reader connection; waits if all of them are in use
+    Lease reader()
+    {
+        std::unique_lock<std::mutex> lock(readers_mutex_);
+        readers_cv_.wait(lock, [this]
+                         { return !idle_readers_.empty(); });
+        DbConnection *conn = idle_readers_.back();
+        idle_readers_.pop_back();
+        return Lease(this, conn, std::unique_lock<std::mutex>());
+    }
+
+private:
+    static bool exec(DbConnection &conn, const std::string &sql)
+    {
+        char *errMsg = nullptr;
+        if (sqlite3_exec(conn.handle(), sql.c_str(), nullptr, nullptr, &errMsg) != SQLITE_OK)
+        {
+            std::cerr << "SQL error: " << (errMsg ? errMsg : "") << "\n";
+            sqlite3_free(errMsg);
+            return false;
+        }
+        return true;
+    }
+
+    static bool openConnection(DbConnection &conn, const DbOptions &options, int flags)
+    {
+        // Each connection is only ever used by one thread at a time, so SQLite's
+        // own per-connection mutex is unnecessary
+        if (!conn.open(options.path.c_str(), flags | SQLITE_OPEN_NOMUTEX))
+        {
+            std::cerr << "Can't open database " << options.path << "\n";
+            return false;
+        }
+        sqlite3_busy_timeout(conn.handle(), options.busy_timeout_ms);
+
+        const std::string &sync = options.synchronous;
+        if (sync != "OFF" && sync != "NORMAL" && sync != "FULL" && sync != "EXTRA")
+        {
+            std::cerr << "Invalid synchronous setting: " << sync << "\n";
+            return false;
+        }
+        return exec(conn, "PRAGMA synchronous=" + sync + ";") &&
+               exec(conn, "PRAGMA cache_size=" + std::to_string(options.cache_size) + ";") &&
+               exec(conn, "PRAGMA mmap_size=" + std::to_string(options.mmap_size) + ";");
+    }
+
+    void releaseReader(DbConnection *conn)
+    {
+        {
+            std::lock_guard<std::mutex> lock(readers_mutex_);
+            idle_readers_.push_back(conn);
+        }
+        readers_cv_.notify_one();
+    }
+
+    DbConnection writer_;
+    std::mutex writer_mutex_;
+    std::vector<DbConnection> readers_;
+    std::vector<DbConnection *> idle_readers_;
+    std::mutex readers_mutex_;
+    std::condition_variable readers_cv_;
+};
+
+ConnectionPool db_pool;
+
+// --------------------------------------------------------------------------------
+// Active sessions, keyed by username. The map is split into shards by a hash of
+// the username, each behind its own reader/writer lock, so concurrent token checks
+// only share a lock with logins that land on the same shard. Every entry carries
+// the latest expiry of the tokens issued for it: an expired entry is treated as
+// absent, and a background sweeper erases them so the store only holds live sessions.
+// An entry also lists its unexpired tokens, and a token is only accepted while its
+// user's entry lists it, so logging out or refreshing revokes it whatever its kind.
+// --------------------------------------------------------------------------------
+class SessionStore
+{
+public:
+    // Adds a token to the user's live session, or starts one. Expiries are jittered,
+    // so a new token can expire before one already issued; the session never ends
+    // earlier than it did, or that token would be cut short.
+    void put(const std::string &username, std::string token, long long expires_at, long long now)
+    {
+        Shard &shard = shardFor(username);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.sessions.find(username);
+        if (it != shard.sessions.end() && it->second.expires_at > now)
+        {
+            dropExpired(it->second, now);
+            it->second.tokens.push_back(IssuedToken{std::move(token), expires_at});
+            it->second.expires_at = std::max(it->second.expires_at, expires_at);
+            return;
+        }
+        Session session;
+        session.tokens.push_back(IssuedToken{std::move(token), expires_at});
+        session.expires_at = expires_at;
+        shard.sessions[username] = std::move(session);
+    }
+
+    // Whether the user has a live session and the token is one it issued and has not
+    // replaced; a token from before a logout, or one traded in by /refresh, is not
+    bool holds(const std::string &username, const std::string &token, long long now) const
+    {
+        const Shard &shard = shardFor(username);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.sessions.find(username);
+        if (it == shard.sessions.end() || it->second.expires_at <= now)
+        {
+            return false;
+        }
+        for (const IssuedToken &issued : it->second.tokens)
+        {
+            if (issued.expires_at > now && issued.value == token)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Replaces one of a live session's tokens with a new one in place, and extends
+    // the session as in put; false if the user has no live session (they logged out,
+    // or it expired, in the meantime)
+    bool renew(const std::string &username, const std::string &old_token, std::string token, long long expires_at,
+               long long now)
+    {
+        Shard &shard = shardFor(username);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.sessions.find(username);
+        if (it == shard.sessions.end() || it->second.expires_at <= now)
+        {
+            return false;
+        }
+        Session &session = it->second;
+        session.tokens.erase(std::remove_if(session.tokens.begin(), session.tokens.end(), [&](const IssuedToken &issued)
+                                            { return issued.value == old_token; }),
+                             session.tokens.end());
+        dropExpired(session, now);
+        session.tokens.push_back(IssuedToken{std::move(token), expires_at});
+        session.expires_at = std::max(session.expires_at, expires_at);
+        return true;
+    }
+
+    // Ends the user's session, returning the tokens it had issued so the caller can
+    // revoke them
+    std::vector<std::string> erase(const std::string &username)
+    {
+        std::vector<IssuedToken> tokens;
+        {
+            Shard &shard = shardFor(username);
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            auto it = shard.sessions.find(username);
+            if (it == shard.sessions.end())
+            {
+                return {};
+            }
+            tokens = std::move(it->second.tokens);
+            shard.sessions.erase(it);
+        }
+        std::vector<std::string> values;
+        values.reserve(tokens.size());
+        for (IssuedToken &issued : tokens)
+        {
+            values.push_back(std::move(issued.value));
+        }
+        return values;
+    }
+
+    // Erases every expired entry, one shard at a time; returns how many were erased
+    size_t sweep(long long now)
+    {
+        size_t erased = 0;
+        for (auto &shard : shards_)
+        {
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            for (auto it = shard.sessions.begin(); it != shard.sessions.end();)
+            {
+                if (it->second.expires_at <= now)
+                {
+                    it = shard.sessions.erase(it);
+                    ++erased;
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+        }
+        swept_.fetch_add(erased, std::memory_order_relaxed);
+        return erased;
+    }
+
+    void startSweeper(std::chrono::seconds interval, const std::vector<int> &cpus = {})
+    {
+        sweeping_ = true;
+        sweeper_  = std::thread([this, interval, cpus]
+                               {
+            pinCurrentThread(cpus);
+            std::unique_lock<std::mutex> lock(sweeper_mutex_);
+            while (!sweeper_cv_.wait_for(lock, interval, [this]
+                                         { return !sweeping_; }))
+            {
+                lock.unlock();
+                sweep(static_cast<long long>(std::time(nullptr)));
+                lock.lock();
+            } });
+    }
+
+    void stopSweeper()
+    {
+        {
+            std::lock_guard<std::mutex> lock(sweeper_mutex_);
+            sweeping_ = false;
+        }
+        sweeper_cv_.notify_all();
+        if (sweeper_.joinable())
+        {
+            sweeper_.join();
+        }
+    }
+
+    json metrics() const
+    {
+        size_t entries = 0;
+        for (const auto &shard : shards_)
+        {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            entries += shard.sessions.size();
+        }
+        json m;
+        m["entries"] = entries;
+        m["swept"]   = swept_.load();
+        m["shards"]  = SHARDS;
+        return m;
+    }
+
+private:
+    static constexpr size_t SHARDS = 64;
+
+    struct IssuedToken
+    {
+        std::string value;
+        long long expires_at;
+    };
+
+    struct Session
+    {
+        std::vector<IssuedToken> tokens; // issued and not yet expired
+        long long expires_at;            // epoch seconds, the latest exp of its tokens
+    };
+
+    // Keeps the list down to the tokens that could still be presented
+    static void dropExpired(Session &session, long long now)
+    {
+        session.tokens.erase(std::remove_if(session.tokens.begin(), session.tokens.end(), [now](const IssuedToken &issued)
+                                            { return issued.expires_at <= now; }),
+                             session.tokens.end());
+    }
+
+    // Padded so that shards on neighbouring cache lines do not contend
+    struct alignas(64) Shard
+    {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, Session> sessions;
+    };
+
+    Shard &shardFor(const std::string &username)
+    {
+        return shards_[std::hash<std::string>{}(username) % SHARDS];
+    }
+
+    const Shard &shardFor(const std::string &username) const
+    {
+        return shards_[std::hash<std::string>{}(username) % SHARDS];
+    }
+
+    Shard shards_[SHARDS];
+    std::atomic<unsigned long long> swept_{0};
+
+    std::thread sweeper_;
+    std::mutex sweeper_mutex_;
+    std::condition_variable sweeper_cv_;
+    bool sweeping_ = false;
+};
+
+SessionStore active_sessions; // Active JWT sessions
+
+// Lifetime of an issued token, and of its session entry
+const std::chrono::seconds SESSION_TTL = std::chrono::hours(1);
+
+// Most that is taken off a token's lifetime, from the session_jitter_s setting
+std::chrono::seconds session_jitter(300);
+
+// The expiry for a token issued now: SESSION_TTL less a random part of the jitter,
+// so that tokens issued in the same burst don't all expire (and come back to be
+// refreshed) in the same second. Whole seconds, like a JWT's exp.
+std::chrono::time_point<std::chrono::system_clock, std::chrono::seconds> sessionExpiry()
+{
+    thread_local std::mt19937 rng{std::random_device{}()};
+    std::uniform_int_distribution<long long> jitter(0, session_jitter.count());
+    return std::chrono::time_point_cast<std::chrono::seconds>(std::chrono::system_clock::now() + SESSION_TTL) -
+           std::chrono::seconds(jitter(rng));
+}
+
+// --------------------------------------------------------------------------------
+// Verified-token cache. The first request with a token pays for decoding it and
+// checking its signature; the subject and expiry are then kept under a hash of the
+// token, so later requests resolve the user with a lookup. The full token is kept
+// too and compared, so a hash collision can never authenticate another token. An
+// entry is dropped at its exp, on logout, or to make room when its shard is full.
+// --------------------------------------------------------------------------------
+class TokenCache
+{
+public:
+    explicit TokenCache(size_t capacity)
+    {
+        setCapacity(capacity);
+    }
+
+    // Not thread-safe; called before the server starts
+    void setCapacity(size_t capacity)
+    {
+        shard_capacity_ = std::max<size_t>(1, capacity / SHARDS);
+    }
+
+    // The token's subject, if it was verified before and has not expired
+    std::optional<std::string> lookup(const std::string &token, long long now)
+    {
+        size_t key   = std::hash<std::string>{}(token);
+        Shard &shard = shards_[key % SHARDS];
+        {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            auto it = shard.entries.find(key);
+            if (it == shard.entries.end() || it->second.token != token)
+            {
+                misses_.fetch_add(1, std::memory_order_relaxed);
+                return std::nullopt;
+            }
+            if (it->second.expires_at > now)
+            {
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                return it->second.subject;
+            }
+        }
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        erase(token);
+        return std::nullopt;
+    }
+
+    void insert(const std::string &token, std::string subject, long long expires_at, long long now)
+    {
+        size_t key   = std::hash<std::string>{}(token);
+        Shard &shard = shards_[key % SHARDS];
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        if (shard.entries.size() >= shard_capacity_ && shard.entries.find(key) == shard.entries.end())
+        {
+            evictSample(shard, key, now);
+        }
+        shard.entries[key] = Entry{token, std::move(subject), expires_at};
+    }
+
+    void erase(const std::string &token)
+    {
+        size_t key   = std::hash<std::string>{}(token);
+        Shard &shard = shards_[key % SHARDS];
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.entries.find(key);
+        if (it != shard.entries.end() && it->second.token == token)
+        {
+            shard.entries.erase(it);
+        }
+    }
+
+    json metrics() const
+    {
+        size_t entries = 0;
+        for (const auto &shard : shards_)
+        {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            entries += shard.entries.size();
+        }
+        json m;
+        m["hits"]     = hits_.load();
+        m["misses"]   = misses_.load();
+        m["entries"]  = entries;
+        m["capacity"] = shard_capacity_ * SHARDS;
+        return m;
+    }
+
+private:
+    static constexpr size_t SHARDS = 16;
+    // A full shard makes room by looking at this many entries, in at most this many
+    // buckets, rather than scanning all of them under the exclusive lock
+    static constexpr size_t EVICT_SAMPLE  = 8;
+    static constexpr size_t EVICT_BUCKETS = 32;
+
+    struct Entry
+    {
+        std::string token;
+        std::string subject;
+        long long expires_at; // epoch seconds, the JWT's exp
+    };
+
+    struct alignas(64) Shard
+    {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<size_t, Entry> entries;
+    };
+
+    // Drops the expired entries among a small sample, or if none has expired the one
+    // that expires first. The sample starts at a bucket picked by the new key, whose
+    // hash is as good as random. Called with the shard's lock held exclusively.
+    static void evictSample(Shard &shard, size_t key, long long now)
+    {
+        std::array<size_t, EVICT_SAMPLE> sampled;
+        size_t count   = 0;
+        size_t buckets = shard.entries.bucket_count();
+        size_t bucket  = (key / SHARDS) % buckets;
+        for (size_t step = 0; step < EVICT_BUCKETS && count < EVICT_SAMPLE; ++step, bucket = (bucket + 1) % buckets)
+        {
+            for (auto it = shard.entries.begin(bucket); it != shard.entries.end(bucket) && count < EVICT_SAMPLE; ++it)
+            {
+                sampled[count++] = it->first;
+            }
+        }
+        if (count == 0)
+        {
+            shard.entries.erase(shard.entries.begin());
+            return;
+        }
+
+        size_t earliest = sampled[0];
+        long long earliest_expiry = std::numeric_limits<long long>::max();
+        bool dropped = false;
+        for (size_t i = 0; i < count; ++i)
+        {
+            long long expires_at = shard.entries.at(sampled[i]).expires_at;
+            if (expires_at <= now)
+            {
+                shard.entries.erase(sampled[i]);
+                dropped = true;
+            }
+            else if (expires_at < earliest_expiry)
+            {
+                earliest        = sampled[i];
+                earliest_expiry = expires_at;
+            }
+        }
+        if (!dropped)
+        {
+            shard.entries.erase(earliest);
+        }
+    }
+
+    Shard shards_[SHARDS];
+    size_t shard_capacity_ = 1;
+    std::atomic<unsigned long long> hits_{0};
+    std::atomic<unsigned long long> misses_{0};
+};
+
+TokenCache token_cache(65536); // sized from the config in main()
+
+// --------------------------------------------------------------------------------
+// Opaque session ids, issued instead of JWTs when auth_tokens = opaque. An id is 128
+// random bits, sent as 32 hex characters; what it stands for only exists here, so
+// checking one is a lookup with nothing to decode or verify. The table has a fixed
+// capacity and uses open addressing with linear probing. The keys are stored in the
+// slots themselves, so a probe compares them without following a pointer, and as
+// they are uniformly random their low bits serve as the hash. It is sharded like the
+// session store. A shard at its load limit drops its expired ids; if none have
+// expired the login is refused.
+// --------------------------------------------------------------------------------
+class OpaqueSessionTable
+{
+public:
+    struct Id
+    {
+        std::uint64_t hi = 0;
+        std::uint64_t lo = 0; // all zero marks an empty slot
+
+        bool operator==(const Id &other) const { return hi == other.hi && lo == other.lo; }
+    };
+
+    explicit OpaqueSessionTable(size_t capacity)
+    {
+        setCapacity(capacity);
+    }
+
+    // Not thread-safe; called before the server starts
+    void setCapacity(size_t capacity)
+    {
+        size_t slots = 8;
+        while (slots * SHARDS < capacity)
+        {
+            slots <<= 1;
+        }
+        for (auto &shard : shards_)
+        {
+            shard.slots.assign(slots, Slot{});
+            shard.size = 0;
+        }
+        mask_     = slots - 1;
+        max_load_ = slots - slots / 8;
+    }
+
+    static Id generate()
+    {
+        Id id;
+        while (id == Id{})
+        {
+            unsigned char bytes[16];
+            if (RAND_bytes(bytes, sizeof(bytes)) != 1)
+            {
+                throw std::runtime_error("RAND_bytes failed");
+            }
+            std::memcpy(&id.hi, bytes, 8);
+            std::memcpy(&id.lo, bytes + 8, 8);
+        }
+        return id;
+    }
+
+    static std::string format(const Id &id)
+    {
+        static const char digits[] = "0123456789abcdef";
+        std::string text(32, '0');
+        for (int i = 0; i < 16; ++i)
+        {
+            text[15 - i] = digits[(id.hi >> (4 * i)) & 0xF];
+            text[31 - i] = digits[(id.lo >> (4 * i)) & 0xF];
+        }
+        return text;
+    }
+
+    // The id a token holds, if it is 32 hex characters
+    static std::optional<Id> parse(const std::string &token)
+    {
+        if (token.size() != 32)
+        {
+            return std::nullopt;
+        }
+        static const std::array<std::int8_t, 256> values = []
+        {
+            std::array<std::int8_t, 256> v;
+            v.fill(-1);
+            for (int i = 0; i < 10; ++i)
+                v['0' + i] = static_cast<std::int8_t>(i);
+            for (int i = 0; i < 6; ++i)
+                v['a' + i] = v['A' + i] = static_cast<std::int8_t>(10 + i);
+            return v;
+        }();
+        Id id;
+        int invalid = 0;
+        for (size_t i = 0; i < 16; ++i)
+        {
+            std::int8_t hi = values[static_cast<unsigned char>(token[i])];
+            std::int8_t lo = values[static_cast<unsigned char>(token[i + 16])];
+            invalid |= hi | lo; // negative for anything but a hex digit
+            id.hi = (id.hi << 4) | static_cast<std::uint64_t>(hi & 0xF);
+            id.lo = (id.lo << 4) | static_cast<std::uint64_t>(lo & 0xF);
+        }
+        if (invalid < 0)
+        {
+            return std::nullopt;
+        }
+        return id;
+    }
+
+    // Adds an id; false when its shard is full of live sessions
+    bool insert(const Id &id, std::string username, long long expires_at, long long now)
+    {
+        Shard &shard = shardFor(id);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        if (shard.size >= max_load_)
+        {
+            sweep(shard, now);
+            if (shard.size >= max_load_)
+            {
+                full_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+        size_t i = id.lo & mask_;
+        while (!(shard.slots[i].id == Id{}) && !(shard.slots[i].id == id))
+        {
+            i = (i + 1) & mask_;
+        }
+        if (shard.slots[i].id == Id{})
+        {
+            ++shard.size;
+        }
+        shard.slots[i] = Slot{id, expires_at, std::move(username)};
+        return true;
+    }
+
+    // The username an id was issued to, if it is known and has not expired
+    std::optional<std::string> lookup(const Id &id, long long now)
+    {
+        Shard &shard = shardFor(id);
+        {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            size_t i = find(shard, id);
+            if (i == NOT_FOUND)
+            {
+                misses_.fetch_add(1, std::memory_order_relaxed);
+                return std::nullopt;
+            }
+            if (shard.slots[i].expires_at > now)
+            {
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                return shard.slots[i].username;
+            }
+        }
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        erase(id);
+        return std::nullopt;
+    }
+
+    void erase(const Id &id)
+    {
+        Shard &shard = shardFor(id);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        size_t i = find(shard, id);
+        if (i != NOT_FOUND)
+        {
+            eraseAt(shard, i);
+        }
+    }
+
+    json metrics() const
+    {
+        size_t entries = 0;
+        for (const auto &shard : shards_)
+        {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            entries += shard.size;
+        }
+        json m;
+        m["hits"]     = hits_.load();
+        m["misses"]   = misses_.load();
+        m["full"]     = full_.load();
+        m["entries"]  = entries;
+        m["capacity"] = max_load_ * SHARDS;
+        return m;
+    }
+
+private:
+    static constexpr size_t SHARDS    = 16;
+    static constexpr size_t NOT_FOUND = static_cast<size_t>(-1);
+
+    struct Slot
+    {
+        Id id;
+        long long expires_at = 0; // epoch seconds
+        std::string username;
+    };
+
+    struct alignas(64) Shard
+    {
+        mutable std::shared_mutex mutex;
+        std::vector<Slot> slots;
+        size_t size = 0;
+    };
+
+    Shard &shardFor(const Id &id)
+    {
+        return shards_[id.hi % SHARDS];
+    }
+
+    size_t find(const Shard &shard, const Id &id) const
+    {
+        for (size_t i = id.lo & mask_; !(shard.slots[i].id == Id{}); i = (i + 1) & mask_)
+        {
+            if (shard.slots[i].id == id)
+            {
+                return i;
+            }
+        }
+        return NOT_FOUND;
+    }
+
+    // Empties slot i and moves later entries of its probe run back into the gap, so
+    // that every entry stays reachable from its home slot without tombstones
+    void eraseAt(Shard &shard, size_t i)
+    {
+        for (size_t j = (i + 1) & mask_; !(shard.slots[j].id == Id{}); j = (j + 1) & mask_)
+        {
+            size_t home = shard.slots[j].id.lo & mask_;
+            bool reachable = i <= j ? (home > i && home <= j) : (home > i || home <= j);
+            if (!reachable)
+            {
+                shard.slots[i] = std::move(shard.slots[j]);
+                i = j;
+            }
+        }
+        shard.slots[i] = Slot{};
+        --shard.size;
+    }
+
+    void sweep(Shard &shard, long long now)
+    {
+        for (size_t i = 0; i < shard.slots.size();)
+        {
+            const Slot &slot = shard.slots[i];
+            if (!(slot.id == Id{}) && slot.expires_at <= now)
+            {
+                eraseAt(shard, i); // i now holds the next entry of the run, if any
+            }
+            else
+            {
+                ++i;
+            }
+        }
+    }
+
+    Shard shards_[SHARDS];
+    size_t mask_     = 0;
+    size_t max_load_ = 0;
+    std::atomic<unsigned long long> hits_{0};
+    std::atomic<unsigned long long> misses_{0};
+    std::atomic<unsigned long long> full_{0};
+};
+
+OpaqueSessionTable opaque_sessions(65536); // sized from the config in main()
 
 struct CORS
 {
-    // Per-request context (not used here, but required by Crow’s middleware interface)
-    struct context
+    // Per-request context (not used here, but required by Crow’s middleware interface)
+    struct context
+    {
+    };
+
+    // Called before each request is handled
+    void before_handle(crow::request &req, crow::response &res, context &)
+    {
+        // Always set the CORS headers
+        // res.add_header("Access-Control-Allow-Origin", "localhost:5173*");
+        res.add_header("Access-Control-Allow-Methods", "GET, POST, PUT, DELETE, OPTIONS");
+        res.add_header("Access-Control-Allow-Headers", "Content-Type, Authorization");
+
+        // If it’s an OPTIONS request, immediately return (typical CORS preflight behavior)
+        if (req.method == "OPTIONS"_method)
+        {
+            // You can use a 200 or 204 here; 204 = No Content
+            res.code = 204;
+            res.end();
+        }
+    }
+
+    // Called after each request is handled
+    void after_handle(crow::request & /*req*/, crow::response &res, context &)
+    {
+        // Ensure that every response has the CORS headers as well
+        res.add_header("Access-Control-Allow-Origin", "*");
+        res.add_header("Access-Control-Allow-Methods", "GET, POST, PUT, DELETE, OPTIONS");
+        res.add_header("Access-Control-Allow-Headers", "Content-Type, Authorization");
+    }
+};
+
+// --------------------------------------------------------------------------------
+// Admission control. Every request is put in a route class: bids (and auction
+// creation), auth, or reads, in that order of priority. Each class has a limit on
+// requests in flight, beyond which it is refused with 429. Request latency is kept
+// per class in a histogram that rolls over every window; while the bid p99 of the
+// last window is over target, reads are shed with 503, and if it stays over twice
+// the target, auth requests too. Shedding relaxes again once bids are well under it.
+// --------------------------------------------------------------------------------
+enum class RouteClass
+{
+    Bid,   // bids and auction creation
+    Auth,  // registration, login and logout
+    Read,  // listings, auction and history reads
+    Other, // preflight and metrics; always admitted
+    Count
+};
+
+const char *routeClassName(RouteClass route_class)
+{
+    switch (route_class)
+    {
+    case RouteClass::Bid:
+        return "bid";
+    case RouteClass::Auth:
+        return "auth";
+    case RouteClass::Read:
+        return "read";
+    default:
+        return "other";
+    }
+}
+
+RouteClass classifyRequest(const crow::request &req)
+{
+    const std::string &url = req.url;
+    if (req.method == "OPTIONS"_method || url == "/metrics")
+    {
+        return RouteClass::Other;
+    }
+    if (url == "/bid" || url == "/create_auction")
+    {
+        return RouteClass::Bid;
+    }
+    if (url == "/login" || url == "/register" || url == "/logout" || url == "/refresh")
+    {
+        return RouteClass::Auth;
+    }
+    return RouteClass::Read;
+}
+
+struct AdmissionOptions
+{
+    long long bid_limit         = 4096; // requests in flight, per class
+    long long auth_limit        = 256;
+    long long read_limit        = 512;
+    long long bid_p99_target_us = 100000;
+    long long window_ms         = 1000; // how often latencies are rolled over
+};
+
+AdmissionOptions admissionOptionsFromConfig(const Config &config)
+{
+    AdmissionOptions options;
+    options.bid_limit         = config.getInt("admit_bid_limit");
+    options.auth_limit        = config.getInt("admit_auth_limit");
+    options.read_limit        = config.getInt("admit_read_limit");
+    options.bid_p99_target_us = config.getInt("bid_p99_target_ms") * 1000;
+    options.window_ms         = config.getInt("admit_window_ms");
+    return options;
+}
+
+// Latency histogram with four buckets per power of two of microseconds
+class LatencyHistogram
+{
+public:
+    static constexpr int BUCKETS = 4 * 32;
+
+    void record(long long us)
+    {
+        counts_[bucketFor(us)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Upper bound of the bucket holding the given quantile, 0 when empty
+    long long quantile(double q) const
+    {
+        unsigned long long total = 0;
+        for (const auto &count : counts_)
+        {
+            total += count.load(std::memory_order_relaxed);
+        }
+        if (total == 0)
+        {
+            return 0;
+        }
+        unsigned long long rank = static_cast<unsigned long long>(q * (total - 1)) + 1;
+        unsigned long long seen = 0;
+        for (int i = 0; i < BUCKETS; ++i)
+        {
+            seen += counts_[i].load(std::memory_order_relaxed);
+            if (seen >= rank)
+            {
+                return upperBound(i);
+            }
+        }
+        return upperBound(BUCKETS - 1);
+    }
+
+    unsigned long long count() const
+    {
+        unsigned long long total = 0;
+        for (const auto &count : counts_)
+        {
+            total += count.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    void clear()
+    {
+        for (auto &count : counts_)
+        {
+            count.store(0, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    static int bucketFor(long long us)
+    {
+        if (us < 1)
+        {
+            return 0;
+        }
+        int octave = 63 - __builtin_clzll(static_cast<unsigned long long>(us));
+        int quarter = octave >= 2 ? static_cast<int>((us >> (octave - 2)) & 3) : 0;
+        return std::min(BUCKETS - 1, octave * 4 + quarter);
+    }
+
+    static long long upperBound(int bucket)
+    {
+        int octave = bucket / 4, quarter = bucket % 4;
+        return (1LL << octave) + ((1LL << octave) >> 2) * (quarter + 1);
+    }
+
+    std::atomic<unsigned long long> counts_[BUCKETS] = {};
+};
+
+class AdmissionController
+{
+public:
+    AdmissionController()
+    {
+        configure(AdmissionOptions{});
+    }
+
+    // Not thread-safe; called before the server starts
+    void configure(const AdmissionOptions &options)
+    {
+        options_ = options;
+        limits_[static_cast<int>(RouteClass::Bid)]  = options.bid_limit;
+        limits_[static_cast<int>(RouteClass::Auth)] = options.auth_limit;
+        limits_[static_cast<int>(RouteClass::Read)] = options.read_limit;
+        window_started_ = steadyMicros();
+    }
+
+    // Returns 0 when the request may run, otherwise the status to refuse it with
+    int admit(RouteClass route_class)
+    {
+        maybeRollWindow();
+        if (route_class == RouteClass::Other)
+        {
+            return 0;
+        }
+        ClassState &state = classes_[static_cast<int>(route_class)];
+        int level = shed_level_.load(std::memory_order_relaxed);
+        if ((route_class == RouteClass::Read && level >= 1) || (route_class == RouteClass::Auth && level >= 2))
+        {
+            state.shed.fetch_add(1, std::memory_order_relaxed);
+            return 503;
+        }
+        if (state.in_flight.fetch_add(1) >= limits_[static_cast<int>(route_class)])
+        {
+            state.in_flight.fetch_sub(1);
+            state.limited.fetch_add(1, std::memory_order_relaxed);
+            return 429;
+        }
+        state.admitted.fetch_add(1, std::memory_order_relaxed);
+        return 0;
+    }
+
+    // Called when an admitted request completes
+    void release(RouteClass route_class, long long latency_us)
+    {
+        if (route_class == RouteClass::Other)
+        {
+            return;
+        }
+        ClassState &state = classes_[static_cast<int>(route_class)];
+        state.in_flight.fetch_sub(1);
+        state.windows[current_.load(std::memory_order_relaxed)].record(latency_us);
+    }
+
+    json metrics() const
+    {
+        json m;
+        int last = 1 - current_.load();
+        for (int i = 0; i < static_cast<int>(RouteClass::Other); ++i)
+        {
+            const ClassState &state = classes_[i];
+            json c;
+            c["in_flight"] = state.in_flight.load();
+            c["limit"]     = limits_[i];
+            c["admitted"]  = state.admitted.load();
+            c["limited"]   = state.limited.load();
+            c["shed"]      = state.shed.load();
+            c["p50_ms"]    = state.windows[last].quantile(0.50) / 1000.0;
+            c["p99_ms"]    = state.windows[last].quantile(0.99) / 1000.0;
+            m[routeClassName(static_cast<RouteClass>(i))] = c;
+        }
+        m["shed_level"]        = shed_level_.load();
+        m["bid_p99_target_ms"] = options_.bid_p99_target_us / 1000.0;
+        m["window_ms"]         = options_.window_ms;
+        return m;
+    }
+
+private:
+    static constexpr int CLASSES = static_cast<int>(RouteClass::Other);
+
+    struct ClassState
+    {
+        std::atomic<long long> in_flight{0};
+        std::atomic<unsigned long long> admitted{0};
+        std::atomic<unsigned long long> limited{0};
+        std::atomic<unsigned long long> shed{0};
+        LatencyHistogram windows[2]; // the one being filled and the last complete one
+    };
+
+    static long long steadyMicros()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // The first request after the window ends swaps the histograms and sets the
+    // shedding level from the bid p99 of the window just completed
+    void maybeRollWindow()
+    {
+        long long now     = steadyMicros();
+        long long started = window_started_.load(std::memory_order_relaxed);
+        if (now - started < options_.window_ms * 1000 ||
+            !window_started_.compare_exchange_strong(started, now))
+        {
+            return;
+        }
+
+        int finished = current_.load();
+        for (auto &state : classes_)
+        {
+            state.windows[1 - finished].clear();
+        }
+        current_.store(1 - finished);
+
+        const LatencyHistogram &bids = classes_[static_cast<int>(RouteClass::Bid)].windows[finished];
+        long long p99 = bids.count() ? bids.quantile(0.99) : 0;
+        int level     = shed_level_.load();
+        if (p99 > 2 * options_.bid_p99_target_us)
+        {
+            level = 2;
+        }
+        else if (p99 > options_.bid_p99_target_us)
+        {
+            level = std::max(level, 1);
+        }
+        else if (p99 < options_.bid_p99_target_us / 2)
+        {
+            level = std::max(level - 1, 0);
+        }
+        shed_level_.store(level);
+    }
+
+    AdmissionOptions options_;
+    long long limits_[CLASSES] = {};
+    ClassState classes_[CLASSES];
+    std::atomic<int> current_{0};
+    std::atomic<long long> window_started_{0};
+    std::atomic<int> shed_level_{0}; // 0: none, 1: reads, 2: reads and auth
+};
+
+AdmissionController admission;
+
+// Crow middleware in front of every route, see AdmissionController
+struct Admission
+{
+    struct context
+    {
+        RouteClass route_class = RouteClass::Other;
+        bool admitted = false;
+        std::chrono::steady_clock::time_point started;
+    };
+
+    void before_handle(crow::request &req, crow::response &res, context &ctx)
+    {
+        ctx.route_class = classifyRequest(req);
+        int refused = admission.admit(ctx.route_class);
+        if (refused)
+        {
+            res.code = refused;
+            res.add_header("Retry-After", "1");
+            res.write(refused == 429 ? "Too many requests, try again." : "Server busy, try again.");
+            return res.end();
+        }
+        ctx.admitted = true;
+        ctx.started  = std::chrono::steady_clock::now();
+    }
+
+    void after_handle(crow::request & /*req*/, crow::response & /*res*/, context &ctx)
+    {
+        if (ctx.admitted)
+        {
+            ctx.admitted = false;
+            auto elapsed = std::chrono::steady_clock::now() - ctx.started;
+            admission.release(ctx.route_class, std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+        }
+    }
+};
+
+crow::App<CORS, Admission> app;
+
+// --------------------------------------------------------------------------------
+// Group commit. Writes from concurrent requests are gathered for a short window (or
+// until the batch is full) and committed in a single transaction, so one fsync
+// covers the whole batch. Each write runs inside its own savepoint, so a failing
+// write is rolled back alone, and its submitter is only told the outcome once the
+// batch has been committed. Submitting never blocks: the outcome is delivered to a
+// completion callback on the commit thread, which is how handlers finish their
+// response without holding a thread while the disk catches up.
+// --------------------------------------------------------------------------------
+struct GroupCommitOptions
+{
+    int window_us;         // how long to wait for more writes after the first one arrives
+    int max_batch;         // writes per transaction
+    std::vector<int> cpus; // affinity of the commit thread, none when empty
+};
+
+GroupCommitOptions groupCommitOptionsFromConfig(const Config &config)
+{
+    GroupCommitOptions options;
+    options.window_us = static_cast<int>(config.getInt("commit_window_us"));
+    options.max_batch = static_cast<int>(config.getInt("commit_max_batch"));
+    options.cpus      = config.getCpus("commit_cpus");
+    return options;
+}
+
+class GroupCommitter
+{
+public:
+    // A write runs on the writer connection inside the batch transaction and returns
+    // false to have its own changes rolled back
+    using Write = std::function<bool(DbConnection &)>;
+    // Called on the commit thread with whether the write is durable; keep it short
+    // and never wait in it (e.g. on a full queue), as the next batch waits for it
+    using Done = std::function<void(bool)>;
+
+    void start(ConnectionPool &pool, const GroupCommitOptions &options)
+    {
+        pool_ = &pool;
+        options_ = options;
+        running_ = true;
+        thread_ = std::thread([this]
+                              {
+            pinCurrentThread(options_.cpus);
+            run(); });
+    }
+
+    // Stops accepting writes, commits whatever is still queued and joins the thread
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_ = false;
+        }
+        cv_.notify_all();
+        if (thread_.joinable())
+        {
+            thread_.join();
+        }
+    }
+
+    // Queues a write; done(true) runs once it is durably committed
+    void submit(Write write, Done done)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (running_)
+            {
+                queue_.push_back(PendingWrite{std::move(write), std::move(done)});
+                done = nullptr;
+            }
+        }
+        if (done)
+        {
+            return done(false);
+        }
+        cv_.notify_one();
+    }
+
+    json metrics() const
+    {
+        json m;
+        unsigned long long batches = batches_.load();
+        unsigned long long writes = writes_.load();
+        m["batches"]           = batches;
+        m["writes"]            = writes;
+        m["failed_writes"]     = failed_writes_.load();
+        m["failed_commits"]    = failed_commits_.load();
+        m["largest_batch"]     = largest_batch_.load();
+        m["writes_per_commit"] = batches ? static_cast<double>(writes) / batches : 0.0;
+        m["window_us"]         = options_.window_us;
+        m["max_batch"]         = options_.max_batch;
+        return m;
+    }
+
+private:
+    struct PendingWrite
+    {
+        Write write;
+        Done done;
+    };
+
+    void run()
+    {
+        while (true)
+        {
+            std::vector<PendingWrite> batch;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this]
+                         { return !queue_.empty() || !running_; });
+                if (queue_.empty() && !running_)
+                {
+                    return;
+                }
+
+                // Give concurrent requests a moment to join this batch
+                auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(options_.window_us);
+                cv_.wait_until(lock, deadline, [this]
+                               { return queue_.size() >= static_cast<size_t>(options_.max_batch) || !running_; });
+
+                size_t count = std::min(queue_.size(), static_cast<size_t>(options_.max_batch));
+                batch.reserve(count);
+                for (size_t i = 0; i < count; ++i)
+                {
+                    batch.push_back(std::move(queue_.front()));
+                    queue_.pop_front();
+                }
+            }
+            commit(batch);
+        }
+    }
+
+    void commit(std::vector<PendingWrite> &batch)
+    {
+        std::vector<bool> ok(batch.size(), false);
+        bool committed = false;
+        {
+            auto db = pool_->writer();
+            sqlite3 *handle = db->handle();
+            if (sqlite3_exec(handle, "BEGIN TRANSACTION;", nullptr, nullptr, nullptr) == SQLITE_OK)
+            {
+                for (size_t i = 0; i < batch.size(); ++i)
+                {
+                    sqlite3_exec(handle, "SAVEPOINT group_write;", nullptr, nullptr, nullptr);
+                    ok[i] = batch[i].write(*db);
+                    if (!ok[i])
+                    {
+                        sqlite3_exec(handle, "ROLLBACK TO group_write;", nullptr, nullptr, nullptr);
+                    }
+                    sqlite3_exec(handle, "RELEASE group_write;", nullptr, nullptr, nullptr);
+                }
+                committed = sqlite3_exec(handle, "COMMIT;", nullptr, nullptr, nullptr) == SQLITE_OK;
+                if (!committed)
+                {
+                    std::cerr << "Group commit failed: " << sqlite3_errmsg(handle) << "\n";
+                    sqlite3_exec(handle, "ROLLBACK;", nullptr, nullptr, nullptr);
+                }
+            }
+        }
+
+        batches_.fetch_add(1, std::memory_order_relaxed);
+        writes_.fetch_add(batch.size(), std::memory_order_relaxed);
+        if (!committed)
+        {
+            failed_commits_.fetch_add(1, std::memory_order_relaxed);
+        }
+        unsigned long long size = batch.size();
+        unsigned long long largest = largest_batch_.load(std::memory_order_relaxed);
+        while (size > largest && !largest_batch_.compare_exchange_weak(largest, size))
+        {
+        }
+
+        for (size_t i = 0; i < batch.size(); ++i)
+        {
+            bool durable = committed && ok[i];
+            if (!durable)
+            {
+                failed_writes_.fetch_add(1, std::memory_order_relaxed);
+            }
+            batch[i].done(durable);
+        }
+    }
+
+    ConnectionPool *pool_ = nullptr;
+    GroupCommitOptions options_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<PendingWrite> queue_;
+    bool running_ = false;
+
+    std::atomic<unsigned long long> batches_{0};
+    std::atomic<unsigned long long> writes_{0};
+    std::atomic<unsigned long long> failed_writes_{0};
+    std::atomic<unsigned long long> failed_commits_{0};
+    std::atomic<unsigned long long> largest_batch_{0};
+};
+
+GroupCommitter group_committer;
+
+// HMAC key for session tokens, from the jwt_secret setting
+std::string jwt_secret = "secret";
+
+// What /login issues and requests present, from the auth_tokens setting
+enum class AuthMode
+{
+    Jwt,
+    Opaque
+};
+AuthMode auth_mode = AuthMode::Jwt;
+
+// Function to generate JWT Token (for authentication), valid until expires_at
+std::string generateToken(const std::string &username, std::chrono::system_clock::time_point expires_at)
+{
+    auto token = jwt::create()
+                     .set_issuer("auction_system")
+                     .set_subject(username)
+                     .set_expires_at(expires_at)
+                     .sign(jwt::algorithm::hs256{jwt_secret});
+    return token;
+}
+
+// Creates a token of the configured kind for a user, valid until expires_at;
+// nothing when the opaque session table has no room
+std::optional<std::string> mintToken(const std::string &username, std::chrono::system_clock::time_point expires_at, long long now)
+{
+    if (auth_mode == AuthMode::Opaque)
+    {
+        OpaqueSessionTable::Id id = OpaqueSessionTable::generate();
+        long long expires = std::chrono::duration_cast<std::chrono::seconds>(expires_at.time_since_epoch()).count();
+        if (!opaque_sessions.insert(id, username, expires, now))
+        {
+            return std::nullopt;
+        }
+        return OpaqueSessionTable::format(id);
+    }
+    return generateToken(username, expires_at);
+}
+
+// Starts a session for a user who has just proved their password, returning its
+// token; the session expires together with the token
+std::optional<std::string> issueToken(const std::string &username)
+{
+    long long now   = static_cast<long long>(std::time(nullptr));
+    auto expires_at = sessionExpiry();
+    std::optional<std::string> token = mintToken(username, expires_at, now);
+    if (token)
+    {
+        active_sessions.put(username, *token, expires_at.time_since_epoch().count(), now);
+    }
+    return token;
+}
+
+// Replaces a valid token of a live session with a new one with a fresh expiry, for
+// refreshing without the password. The session entry is renewed in place and no
+// longer lists the old token, so it stops working at once, whatever its kind; it is
+// also dropped from the caches. Nothing when the session ended meanwhile or the
+// opaque session table is full.
+std::optional<std::string> refreshToken(const std::string &username, const std::string &old_token)
+{
+    long long now   = static_cast<long long>(std::time(nullptr));
+    auto expires_at = sessionExpiry();
+    std::optional<std::string> token = mintToken(username, expires_at, now);
+    if (!token)
+    {
+        return std::nullopt;
+    }
+    if (!active_sessions.renew(username, old_token, *token, expires_at.time_since_epoch().count(), now))
+    {
+        if (std::optional<OpaqueSessionTable::Id> id = OpaqueSessionTable::parse(*token))
+        {
+            opaque_sessions.erase(*id);
+        }
+        return std::nullopt;
+    }
+    if (std::optional<OpaqueSessionTable::Id> old_id = OpaqueSessionTable::parse(old_token))
+    {
+        opaque_sessions.erase(*old_id);
+    }
+    token_cache.erase(old_token);
+    return token;
+}
+
+// Ends the user's session, for /logout. A session started by a later login does not
+// list its tokens, so none of them is accepted again; they are also dropped from the
+// token cache and the opaque table, to free their slots.
+void endSession(const std::string &username, const std::string &token)
+{
+    std::vector<std::string> tokens = active_sessions.erase(username);
+    tokens.push_back(token);
+    for (const std::string &issued : tokens)
+    {
+        token_cache.erase(issued);
+        if (std::optional<OpaqueSessionTable::Id> id = OpaqueSessionTable::parse(issued))
+        {
+            opaque_sessions.erase(*id);
+        }
+    }
+}
+
+// Function to authenticate a request's token: returns the username when the token
+// is valid and is one its user's live session lists. A JWT is valid when it is signed
+// with our key and not expired; verified JWTs are cached, so only the first request
+// with one decodes it. An opaque id is valid while the table holds it.
+std::optional<std::string> authenticate(const std::string &token)
+{
+    long long now = static_cast<long long>(std::time(nullptr));
+    if (auth_mode == AuthMode::Opaque)
+    {
+        std::optional<OpaqueSessionTable::Id> id = OpaqueSessionTable::parse(token);
+        std::optional<std::string> username = id ? opaque_sessions.lookup(*id, now) : std::nullopt;
+        if (username && active_sessions.holds(*username, token, now))
+        {
+            return username;
+        }
+        return std::nullopt;
+    }
+
+    if (std::optional<std::string> username = token_cache.lookup(token, now))
+    {
+        // Checked on every request, so that logging out or refreshing ends a token
+        if (active_sessions.holds(*username, token, now))
+        {
+            return username;
+        }
+        return std::nullopt;
+    }
+
+    try
+    {
+        // Only sub, exp and iss are read, so the token is parsed in place rather
+        // than through jwt::decode's copies and full JSON claim maps
+        jwt::decoded_jwt_view decoded(token);
+        std::error_code ec;
+        decoded.verify(jwt::algorithm::hs256{jwt_secret}, ec);
+        if (ec || !decoded.has_issuer() || decoded.get_issuer() != "auction_system" ||
+            !decoded.has_subject() || !decoded.has_expires_at())
+        {
+            return std::nullopt;
+        }
+        std::string username = decoded.get_subject();
+        long long expires_at = std::chrono::duration_cast<std::chrono::seconds>(decoded.get_expires_at().time_since_epoch()).count();
+        if (expires_at <= now || !active_sessions.holds(username, token, now))
+        {
+            return std::nullopt;
+        }
+        token_cache.insert(token, username, expires_at, now);
+        return username;
+    }
+    catch (const std::exception &)
+    {
+        return std::nullopt;
+    }
+}
+
+// Parse a string datetime "YYYY-MM-DD HH:MM:SS" (local time) into epoch seconds.
+// Returns 0 if parsing fails or string empty. This is only called when an auction
+// is created (and by the migration that converted existing rows): std::mktime
+// takes the global timezone lock, so the bid path compares stored epochs instead.
+long long parseDateTime(const std::string &datetime_str)
+{
+    if (datetime_str.empty())
+    {
+        return 0;
+    }
+    std::tm tm{};
+    std::istringstream ss(datetime_str);
+    ss >> std::get_time(&tm, "%Y-%m-%d %H:%M:%S");
+    if (ss.fail())
+    {
+        // If parse fails, return epoch
+        return 0;
+    }
+    tm.tm_isdst = -1;
+    auto time_c = std::mktime(&tm);
+    return time_c == static_cast<std::time_t>(-1) ? 0 : static_cast<long long>(time_c);
+}
+
+// Current time in epoch seconds, for comparing against stored end times
+long long nowEpoch()
+{
+    return std::chrono::duration_cast<std::chrono::seconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+// --------------------------------------------------------------------------------
+// In-memory auction book. This is the authoritative copy of every auction's bidding
+// state: bids are accepted or rejected against it and accepted bids are then
+// written to the auctions table through the group-commit stage. The book is split
+// into shards by auction id (see BidShard below).
+// --------------------------------------------------------------------------------
+struct AuctionRecord
+{
+    std::string item;
+    double starting_price = 0.0;
+    double highest_bid = 0.0;
+    std::string highest_bidder;
+    std::string end_datetime; // as submitted / returned on the API
+    long long end_epoch = 0;  // end time in epoch seconds, 0 when there is none
+    std::string owner;
+    bool closed = false;      // set by the auction closer once the end time has passed
+};
+
+json auctionToJson(int auction_id, const AuctionRecord &record)
+{
+    json auction;
+    auction["id"]             = auction_id;
+    auction["item"]           = record.item;
+    auction["starting_price"] = record.starting_price;
+    auction["highest_bid"]    = record.highest_bid;
+    auction["highest_bidder"] = record.highest_bidder;
+    auction["end_datetime"]   = record.end_datetime;
+    auction["owner"]          = record.owner;
+    auction["closed"]         = record.closed;
+    auction["winner"]         = record.closed ? record.highest_bidder : "";
+    return auction;
+}
+
+// Function to insert a new auction row (run by the group committer); stores its id
+bool insertAuction(DbConnection &db, const AuctionRecord &record, long long &id)
+{
+    const char *sql = "INSERT INTO auctions (item, starting_price, highest_bid, highest_bidder, end_datetime, owner, end_epoch) "
+                      "VALUES (?, ?, 0.0, '', ?, ?, ?);";
+    CachedStatement cached = db.prepare(sql);
+    if (!cached)
+    {
+        return false;
+    }
+    sqlite3_stmt *stmt = cached.get();
+    sqlite3_bind_text(stmt, 1, record.item.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_double(stmt, 2, record.starting_price);
+    sqlite3_bind_text(stmt, 3, record.end_datetime.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 4, record.owner.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(stmt, 5, record.end_epoch);
+
+    if (sqlite3_step(stmt) != SQLITE_DONE)
+    {
+        return false;
+    }
+    id = sqlite3_last_insert_rowid(db.handle());
+    return true;
+}
+
+// Function to write an accepted bid (run by the group committer): appends it to the
+// bids history and updates the auction, inside the same batch transaction.
+// Each shard sends its bids in order, one batch at a time, so within this process a
+// lower bid never follows a higher one. The highest_bid guard stays because the shard
+// only owns its in-memory copy: another process writing the same database file, or a
+// row fixed by hand, can be ahead of it, and the update must not move the row back.
+bool writeBid(DbConnection &db, int auction_id, double bid_amount, const std::string &bidder, long long placed_at)
+{
+    CachedStatement history = db.prepare("INSERT INTO bids (auction_id, bidder, amount, placed_at) VALUES (?, ?, ?, ?);");
+    if (!history)
+    {
+        return false;
+    }
+    sqlite3_bind_int(history.get(), 1, auction_id);
+    sqlite3_bind_text(history.get(), 2, bidder.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_double(history.get(), 3, bid_amount);
+    sqlite3_bind_int64(history.get(), 4, placed_at);
+    if (sqlite3_step(history.get()) != SQLITE_DONE)
+    {
+        return false;
+    }
+
+    const char *sql = "UPDATE auctions SET highest_bid = ?, highest_bidder = ? WHERE id = ? AND highest_bid < ?;";
+    CachedStatement cached = db.prepare(sql);
+    if (!cached)
+    {
+        return false;
+    }
+    sqlite3_stmt *stmt = cached.get();
+    sqlite3_bind_double(stmt, 1, bid_amount);
+    sqlite3_bind_text(stmt, 2, bidder.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 3, auction_id);
+    sqlite3_bind_double(stmt, 4, bid_amount);
+    return sqlite3_step(stmt) == SQLITE_DONE;
+}
+
+// Function to mark an auction closed and record its winner (run by the group
+// committer); the winner is empty when nobody bid
+bool closeAuction(DbConnection &db, int auction_id, const std::string &winner)
+{
+    CachedStatement cached = db.prepare("UPDATE auctions SET closed = 1, winner = ? WHERE id = ?;");
+    if (!cached)
+    {
+        return false;
+    }
+    sqlite3_stmt *stmt = cached.get();
+    sqlite3_bind_text(stmt, 1, winner.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 2, auction_id);
+    return sqlite3_step(stmt) == SQLITE_DONE;
+}
+
+// Outcome of a compare-and-set bid against the auction book. highest_bid and
+// highest_bidder are the auction's values after the attempt, whether it won or not.
+enum class BidStatus
+{
+    Accepted,
+    NotFound,
+    Ended,
+    TooLow,
+    Failed // accepted, but the write could not be committed, so it was undone
+};
+
+struct BidOutcome
+{
+    BidStatus status = BidStatus::NotFound;
+    double highest_bid = 0.0;
+    std::string highest_bidder;
+    double previous_bid = 0.0;
+    std::string previous_bidder;
+    std::string owner;
+};
+
+// Checks that the auction is open and the current highest bid and applies the bid
+// in one step. The closer normally flags an auction at its end time; the epoch
+// compare only covers the moment between the end and that tick.
+BidOutcome applyBid(std::unordered_map<int, AuctionRecord> &auctions, int auction_id, double bid_amount,
+                    const std::string &bidder, long long now)
+{
+    BidOutcome outcome;
+    auto it = auctions.find(auction_id);
+    if (it == auctions.end())
+    {
+        return outcome;
+    }
+
+    AuctionRecord &auction = it->second;
+    outcome.owner          = auction.owner;
+    outcome.highest_bid    = auction.highest_bid;
+    outcome.highest_bidder = auction.highest_bidder;
+    if (auction.closed || (auction.end_epoch != 0 && now >= auction.end_epoch))
+    {
+        outcome.status = BidStatus::Ended;
+    }
+    else if (bid_amount <= auction.highest_bid)
+    {
+        outcome.status = BidStatus::TooLow;
+    }
+    else
+    {
+        outcome.status          = BidStatus::Accepted;
+        outcome.previous_bid    = auction.highest_bid;
+        outcome.previous_bidder = auction.highest_bidder;
+        auction.highest_bid     = outcome.highest_bid = bid_amount;
+        auction.highest_bidder  = outcome.highest_bidder = bidder;
+    }
+    return outcome;
+}
+
+// --------------------------------------------------------------------------------
+// Bounded lock-free multi-producer/single-consumer ring (Vyukov's sequence-numbered
+// slots). Producers claim a slot with one compare-and-swap on the tail and publish
+// it by bumping the slot's sequence; the single consumer reads slots in order
+// without any atomic read-modify-write. A full ring rejects the push instead of
+// blocking, so the caller can shed the request.
+// --------------------------------------------------------------------------------
+template <typename T>
+class MpscRing
+{
+public:
+    // The capacity is rounded up to a power of two
+    explicit MpscRing(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        mask_  = size - 1;
+        slots_ = std::make_unique<Slot[]>(size);
+        for (size_t i = 0; i < size; ++i)
+        {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscRing(const MpscRing &)            = delete;
+    MpscRing &operator=(const MpscRing &) = delete;
+
+    // Moves from value only when the push succeeds; returns false when the ring is full
+    bool tryPush(T &value)
+    {
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        while (true)
+        {
+            Slot &slot    = slots_[pos & mask_];
+            size_t seq    = slot.sequence.load(std::memory_order_acquire);
+            auto distance = static_cast<std::ptrdiff_t>(seq - pos);
+            if (distance == 0)
+            {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    slot.value = std::move(value);
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (distance < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Consumer thread only
+    bool tryPop(T &value)
+    {
+        Slot &slot = slots_[head_ & mask_];
+        if (slot.sequence.load(std::memory_order_acquire) != head_ + 1)
+        {
+            return false;
+        }
+        value      = std::move(slot.value);
+        slot.value = T();
+        slot.sequence.store(head_ + mask_ + 1, std::memory_order_release);
+        head_pos_.store(++head_, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Approximate when read concurrently with pushes and pops
+    size_t size() const
+    {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t head = head_pos_.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+    size_t capacity() const
+    {
+        return mask_ + 1;
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<size_t> sequence{0};
+        T value;
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    size_t mask_ = 0;
+    // Producers and the consumer touch different cache lines
+    alignas(64) std::atomic<size_t> tail_{0};
+    alignas(64) size_t head_ = 0;
+    std::atomic<size_t> head_pos_{0};
+};
+
+// Defined with the response cache below
+void bumpListingVersions(const std::string &owner);
+
+// --------------------------------------------------------------------------------
+// Sharded bid processing. Auctions are spread over N shards by a hash of their id.
+// Each shard is a single-writer actor: one thread owns the shard's auctions and
+// runs the commands posted to its mailbox one after another, so that state needs
+// no lock and a bidding war on one auction only queues behind its own shard. The
+// mailbox is a bounded lock-free ring, so handler threads never park on a lock to
+// post a bid, and a full mailbox rejects the request instead of queueing it. The
+// bids accepted while draining one mailbox batch are committed to SQLite as a
+// single group-commit write, and their requests are completed after the commit.
+// --------------------------------------------------------------------------------
+class BidShard
+{
+public:
+    using BidCallback = std::function<void(const BidOutcome &)>;
+    using GetCallback = std::function<void(const AuctionRecord *)>;
+
+    explicit BidShard(size_t mailbox_capacity) : mailbox_(mailbox_capacity) {}
+
+    // Seeds the shard before start(); not thread-safe
+    void load(int auction_id, AuctionRecord record)
+    {
+        auctions_[auction_id] = std::move(record);
+    }
+
+    void start(const std::vector<int> &cpus = {})
+    {
+        running_ = true;
+        thread_ = std::thread([this, cpus]
+                              {
+            pinCurrentThread(cpus);
+            run(); });
+    }
+
+    // Runs every command already posted and commits every accepted bid, then joins
+    // the shard thread
+    void stop()
+    {
+        running_ = false;
+        wake();
+        if (thread_.joinable())
+        {
+            thread_.join();
+        }
+    }
+
+    // Bids and reads are completed on the shard thread via their callback. They
+    // return false, without calling it, when the mailbox is full.
+    bool placeBid(int auction_id, double bid_amount, std::string bidder, long long now, BidCallback done)
+    {
+        return tryPost([this, auction_id, bid_amount, bidder = std::move(bidder), now, done = std::move(done)]() mutable
+             {
+            BidOutcome outcome = applyBid(auctions_, auction_id, bid_amount, bidder, now);
+            if (outcome.status == BidStatus::Accepted)
+            {
+                accepted_.push_back(AcceptedBid{auction_id, bid_amount, std::move(bidder), now, outcome, std::move(done)});
+            }
+            else
+            {
+                done(outcome);
+            } });
+    }
+
+    bool getAuction(int auction_id, GetCallback done)
+    {
+        return tryPost([this, auction_id, done = std::move(done)]
+             {
+            auto it = auctions_.find(auction_id);
+            done(it != auctions_.end() ? &it->second : nullptr); });
+    }
+
+    // The auction is already committed, so this goes through the control queue,
+    // which never fills, rather than fail
+    void addAuction(int auction_id, AuctionRecord record)
+    {
+        postControl([this, auction_id, record = std::move(record)]() mutable
+             { auctions_[auction_id] = std::move(record); });
+    }
+
+    // Flags the auctions closed, from the auction closer; the flags are written with
+    // the shard's next batch, along with the winners. Like addAuction, never dropped.
+    void closeAuctions(std::vector<int> auction_ids, long long now)
+    {
+        postControl([this, auction_ids = std::move(auction_ids), now]
+             {
+            for (int auction_id : auction_ids)
+            {
+                auto it = auctions_.find(auction_id);
+                if (it == auctions_.end() || it->second.closed ||
+                    it->second.end_epoch == 0 || now < it->second.end_epoch)
+                {
+                    continue;
+                }
+                it->second.closed = true;
+                closing_.push_back(auction_id);
+            } });
+    }
+
+    size_t mailboxCapacity() const
+    {
+        return mailbox_.capacity();
+    }
+
+    json metrics() const
+    {
+        json m;
+        m["commands"]      = commands_.load();
+        m["batches"]       = batches_.load();
+        m["bids_accepted"] = bids_accepted_.load();
+        m["commits"]       = commits_.load();
+        m["closed"]        = closed_.load();
+        m["rejected"]      = rejected_.load();
+        m["mailbox_depth"] = mailbox_.size();
+        return m;
+    }
+
+private:
+    using Command = std::function<void()>;
+
+    struct AcceptedBid
+    {
+        int auction_id;
+        double bid_amount;
+        std::string bidder;
+        long long placed_at;
+        BidOutcome outcome;
+        BidCallback done;
+    };
+
+    bool tryPost(Command command)
+    {
+        if (!mailbox_.tryPush(command))
+        {
+            rejected_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        wakeIfSleeping();
+        return true;
+    }
+
+    // Commands that must not be dropped (new auctions, closes, commit completions)
+    // go to an unbounded queue beside the mailbox. The group committer posts here, so
+    // a mailbox full of bids can never stall it; the queue stays short, as each
+    // command on it is one per committed batch or closer pass.
+    void postControl(Command command)
+    {
+        {
+            std::lock_guard<std::mutex> lock(control_mutex_);
+            control_.push_back(std::move(command));
+            has_control_.store(true, std::memory_order_release);
+        }
+        wakeIfSleeping();
+    }
+
+    // Runs the control commands posted so far; returns how many
+    size_t runControl()
+    {
+        std::vector<Command> commands;
+        {
+            std::lock_guard<std::mutex> lock(control_mutex_);
+            commands.swap(control_);
+            has_control_.store(false, std::memory_order_relaxed);
+        }
+        for (Command &command : commands)
+        {
+            command();
+        }
+        return commands.size();
+    }
+
+    // Pairs with the fence in run(): either the shard thread sees the new command
+    // before it sleeps, or this sees it sleeping
+    void wakeIfSleeping()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping_.load(std::memory_order_relaxed))
+        {
+            wake();
+        }
+    }
+
+    // The lock only orders the wakeup with the shard thread's check before it sleeps
+    void wake()
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        sleep_cv_.notify_one();
+    }
+
+    void run()
+    {
+        Command command;
+        while (true)
+        {
+            size_t drained = 0;
+            if (has_control_.load(std::memory_order_acquire))
+            {
+                drained += runControl();
+            }
+            while (drained < MAX_DRAIN && mailbox_.tryPop(command))
+            {
+                // A bid for a new auction is posted after its addAuction returned, so
+                // the flag is already visible once the bid has been popped
+                if (has_control_.load(std::memory_order_acquire))
+                {
+                    drained += runControl();
+                }
+                command();
+                command = nullptr;
+                ++drained;
+            }
+
+            if (drained > 0)
+            {
+                commands_.fetch_add(drained, std::memory_order_relaxed);
+                batches_.fetch_add(1, std::memory_order_relaxed);
+                commitAccepted();
+                continue;
+            }
+
+            // Empty: announce that the thread is about to sleep, then look again, so
+            // a producer either sees the flag or its command is seen here
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            sleeping_.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            // Stopping also waits for the batch in flight, whose completion is posted here
+            sleep_cv_.wait(lock, [this]
+                           { return mailbox_.size() > 0 || has_control_.load(std::memory_order_acquire) ||
+                                    (!running_ && !commit_in_flight_); });
+            sleeping_.store(false, std::memory_order_relaxed);
+            if (!running_ && !commit_in_flight_ && mailbox_.size() == 0 &&
+                !has_control_.load(std::memory_order_acquire))
+            {
+                return;
+            }
+        }
+    }
+
+    // Sends the bids accepted so far to the group committer as one write. Only one
+    // batch is in flight at a time: the shard keeps running commands meanwhile, and
+    // the bids it accepts form the next batch, sent when this one has finished.
+    void commitAccepted()
+    {
+        if (commit_in_flight_ || (accepted_.empty() && closing_.empty()))
+        {
+            return;
+        }
+
+        committing_.swap(accepted_);
+        committing_closes_.swap(closing_);
+        std::vector<std::tuple<int, double, std::string, long long>> rows;
+        rows.reserve(committing_.size());
+        for (const auto &bid : committing_)
+        {
+            rows.emplace_back(bid.auction_id, bid.bid_amount, bid.bidder, bid.placed_at);
+        }
+        // The winner is the highest bidder including this batch's bids, which are
+        // written first in the same transaction
+        std::vector<std::pair<int, std::string>> closes;
+        closes.reserve(committing_closes_.size());
+        for (int auction_id : committing_closes_)
+        {
+            closes.emplace_back(auction_id, auctions_[auction_id].highest_bidder);
+        }
+        commit_in_flight_ = true;
+        group_committer.submit([rows = std::move(rows), closes = std::move(closes)](DbConnection &db)
+                               {
+            for (const auto &row : rows)
+            {
+                if (!writeBid(db, std::get<0>(row), std::get<1>(row), std::get<2>(row), std::get<3>(row)))
+                {
+                    return false;
+                }
+            }
+            for (const auto &close : closes)
+            {
+                if (!closeAuction(db, close.first, close.second))
+                {
+                    return false;
+                }
+            }
+            return true; }, [this](bool durable)
+                               { postControl([this, durable]
+                                      { commitFinished(durable); }); });
+    }
+
+    // Runs on the shard thread once the batch in flight is committed or has failed,
+    // and completes its requests
+    void commitFinished(bool durable)
+    {
+        commit_in_flight_ = false;
+        commits_.fetch_add(1, std::memory_order_relaxed);
+
+        if (!durable)
+        {
+            // Bids accepted since the batch was sent were checked against its state, so
+            // they fail with it. Undo newest first, which restores exactly the state
+            // before the batch.
+            failBids(accepted_);
+            failBids(committing_);
+            completeBids(accepted_);
+        }
+        else
+        {
+            bids_accepted_.fetch_add(committing_.size(), std::memory_order_relaxed);
+        }
+        completeBids(committing_);
+
+        // A close that failed to be written stays closed here; as the row is still
+        // open, the next startup schedules it again and it is written then
+        if (durable)
+        {
+            closed_.fetch_add(committing_closes_.size(), std::memory_order_relaxed);
+            for (int auction_id : committing_closes_)
+            {
+                bumpListingVersions(auctions_[auction_id].owner);
+            }
+        }
+        else if (!committing_closes_.empty())
+        {
+            std::cerr << "Failed to record " << committing_closes_.size() << " closed auctions.\n";
+        }
+        committing_closes_.clear();
+    }
+
+    void failBids(std::vector<AcceptedBid> &bids)
+    {
+        for (auto it = bids.rbegin(); it != bids.rend(); ++it)
+        {
+            AuctionRecord &auction = auctions_[it->auction_id];
+            auction.highest_bid    = it->outcome.previous_bid;
+            auction.highest_bidder = it->outcome.previous_bidder;
+            it->outcome.status         = BidStatus::Failed;
+            it->outcome.highest_bid    = it->outcome.previous_bid;
+            it->outcome.highest_bidder = it->outcome.previous_bidder;
+        }
+    }
+
+    void completeBids(std::vector<AcceptedBid> &bids)
+    {
+        for (auto &bid : bids)
+        {
+            bid.done(bid.outcome);
+        }
+        bids.clear();
+    }
+
+    // Owned by the shard thread
+    std::unordered_map<int, AuctionRecord> auctions_;
+    std::vector<AcceptedBid> accepted_;   // not yet sent to the committer
+    std::vector<AcceptedBid> committing_; // the batch in flight
+    std::vector<int> closing_;            // auctions closed, not yet sent
+    std::vector<int> committing_closes_;  // closes in the batch in flight
+    bool commit_in_flight_ = false;
+
+    // Upper bound on the commands run (and bids committed) per batch
+    static constexpr size_t MAX_DRAIN = 512;
+
+    std::thread thread_;
+    MpscRing<Command> mailbox_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> sleeping_{false};
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_cv_;
+    std::mutex control_mutex_;
+    std::vector<Command> control_;
+    std::atomic<bool> has_control_{false};
+
+    std::atomic<unsigned long long> commands_{0};
+    std::atomic<unsigned long long> batches_{0};
+    std::atomic<unsigned long long> bids_accepted_{0};
+    std::atomic<unsigned long long> commits_{0};
+    std::atomic<unsigned long long> rejected_{0};
+    std::atomic<unsigned long long> closed_{0};
+};
+
+std::vector<std::unique_ptr<BidShard>> bid_shards;
+
+BidShard &shardFor(int auction_id)
+{
+    // Fibonacci hashing, so consecutive auction ids land on different shards
+    unsigned long long h = static_cast<unsigned long long>(static_cast<unsigned int>(auction_id)) * 11400714819323198485ull;
+    return *bid_shards[(h >> 32) % bid_shards.size()];
+}
+
+// --------------------------------------------------------------------------------
+// Hierarchical timer wheel with a one-second tick. Level 0 has one slot per second
+// of the next 64; each level above covers 64 slots of the level below. An entry is
+// put on the lowest level whose span still contains its due time, and when the
+// wheel reaches the start of a higher-level slot, that slot's entries cascade down.
+// Scheduling and firing are O(1) per entry, whatever the number of pending timers.
+// --------------------------------------------------------------------------------
+class TimerWheel
+{
+public:
+    explicit TimerWheel(long long now) : current_(now) {}
+
+    // Entries already due fire on the next advance()
+    void schedule(int id, long long when)
+    {
+        if (when <= current_)
+        {
+            due_.push_back(Entry{id, when});
+        }
+        else
+        {
+            insert(Entry{id, when});
+        }
+        ++pending_;
+    }
+
+    // Moves the wheel forward to now, calling fire(id) for every entry that is due
+    template <typename F>
+    void advance(long long now, F &&fire)
+    {
+        fireAll(due_, fire);
+        while (current_ < now)
+        {
+            ++current_;
+            // Cascade from the top, so entries land in lower slots before those are
+            // cascaded or fired in this same tick
+            for (int level = LEVELS; level >= 1; --level)
+            {
+                if ((current_ & ((1LL << (SLOT_BITS * level)) - 1)) == 0)
+                {
+                    cascade(level);
+                }
+            }
+            fireAll(levels_[0][current_ & SLOT_MASK], fire);
+        }
+    }
+
+    size_t pending() const
+    {
+        return pending_;
+    }
+
+private:
+    static constexpr int SLOT_BITS = 6;
+    static constexpr int SLOTS     = 1 << SLOT_BITS;
+    static constexpr int SLOT_MASK = SLOTS - 1;
+    static constexpr int LEVELS    = 4; // covers 2^24 s (194 days); later entries overflow
+
+    struct Entry
     {
+        int id;
+        long long when;
     };
 
-    // Called before each request is handled
-    void before_handle(crow::request &req, crow::response &res, context &)
+    // Needs entry.when >= current_. An entry due now goes to current_'s level-0 slot,
+    // which, while cascading, is fired right after.
+    void insert(Entry entry)
     {
-        // Always set the CORS headers
-        // res.add_header("Access-Control-Allow-Origin", "localhost:5173*");
-        res.add_header("Access-Control-Allow-Methods", "GET, POST, PUT, DELETE, OPTIONS");
-        res.add_header("Access-Control-Allow-Headers", "Content-Type, Authorization");
+        // The lowest level whose next-higher slot is the one current_ is in; its own
+        // slot is then strictly ahead of current_'s (or the same one, on level 0)
+        for (int level = 0; level < LEVELS; ++level)
+        {
+            int above = SLOT_BITS * (level + 1);
+            if ((entry.when >> above) == (current_ >> above))
+            {
+                levels_[level][(entry.when >> (SLOT_BITS * level)) & SLOT_MASK].push_back(entry);
+                return;
+            }
+        }
+        overflow_.push_back(entry);
+    }
 
-        // If it’s an OPTIONS request, immediately return (typical CORS preflight behavior)
-        if (req.method == "OPTIONS"_method)
+    void cascade(int level)
+    {
+        std::vector<Entry> entries;
+        if (level == LEVELS)
         {
-            // You can use a 200 or 204 here; 204 = No Content
-            res.code = 204;
-            res.end();
+            entries.swap(overflow_);
+        }
+        else
+        {
+            entries.swap(levels_[level][(current_ >> (SLOT_BITS * level)) & SLOT_MASK]);
+        }
+        for (const Entry &entry : entries)
+        {
+            insert(entry);
         }
     }
 
-    // Called after each request is handled
-    void after_handle(crow::request & /*req*/, crow::response &res, context &)
+    template <typename F>
+    void fireAll(std::vector<Entry> &slot, F &fire)
+    {
+        std::vector<Entry> entries;
+        entries.swap(slot);
+        pending_ -= entries.size();
+        for (const Entry &entry : entries)
+        {
+            fire(entry.id);
+        }
+    }
+
+    long long current_;
+    size_t pending_ = 0;
+    std::vector<Entry> levels_[LEVELS][SLOTS];
+    std::vector<Entry> due_;
+    std::vector<Entry> overflow_;
+};
+
+// --------------------------------------------------------------------------------
+// Auction closer. Keeps every open auction's end time on a timer wheel and, once a
+// second, hands the auctions that just ended to their shards, which flag them closed
+// and record the winners with their next batch write.
+// --------------------------------------------------------------------------------
+class AuctionCloser
+{
+public:
+    AuctionCloser() : wheel_(static_cast<long long>(std::time(nullptr))) {}
+
+    void schedule(int auction_id, long long end_epoch)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        wheel_.schedule(auction_id, end_epoch);
+    }
+
+    void start(const std::vector<int> &cpus = {})
+    {
+        running_ = true;
+        thread_  = std::thread([this, cpus]
+                              {
+            pinCurrentThread(cpus);
+            run(); });
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_ = false;
+        }
+        cv_.notify_all();
+        if (thread_.joinable())
+        {
+            thread_.join();
+        }
+    }
+
+    json metrics() const
+    {
+        json m;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            m["pending"] = wheel_.pending();
+        }
+        m["fired"] = fired_.load();
+        return m;
+    }
+
+private:
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (running_)
+        {
+            // Fire every auction whose end second has begun, grouped by shard
+            long long now = static_cast<long long>(std::time(nullptr));
+            std::unordered_map<BidShard *, std::vector<int>> due;
+            wheel_.advance(now, [&due](int auction_id)
+                           { due[&shardFor(auction_id)].push_back(auction_id); });
+
+            lock.unlock();
+            for (auto &shard : due)
+            {
+                fired_.fetch_add(shard.second.size(), std::memory_order_relaxed);
+                shard.first->closeAuctions(std::move(shard.second), now);
+            }
+            lock.lock();
+
+            // Wake at the start of the next second
+            auto next = std::chrono::system_clock::from_time_t(static_cast<std::time_t>(now + 1));
+            cv_.wait_until(lock, next, [this]
+                           { return !running_; });
+        }
+    }
+
+    TimerWheel wheel_;
+    std::thread thread_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    bool running_ = false;
+    std::atomic<unsigned long long> fired_{0};
+};
+
+AuctionCloser auction_closer;
+
+// Function to load every auction from the database into the auction book shards
+// (before the shard threads are started), scheduling the open ones to close
+void loadAuctionBook()
+{
+    auto db = db_pool.reader();
+    const char *sql = "SELECT id, item, starting_price, highest_bid, highest_bidder, end_datetime, owner, end_epoch, closed "
+                      "FROM auctions;";
+    CachedStatement cached = db->prepare(sql);
+    if (!cached)
+    {
+        std::cerr << "Failed to load auctions.\n";
+        return;
+    }
+    sqlite3_stmt *stmt = cached.get();
+
+    size_t loaded = 0, scheduled = 0;
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        AuctionRecord record;
+        const unsigned char *it = sqlite3_column_text(stmt, 1);
+        record.item           = it ? reinterpret_cast<const char *>(it) : "";
+        record.starting_price = sqlite3_column_double(stmt, 2);
+        record.highest_bid    = sqlite3_column_double(stmt, 3);
+        const unsigned char *hb = sqlite3_column_text(stmt, 4);
+        record.highest_bidder = hb ? reinterpret_cast<const char *>(hb) : "";
+        const unsigned char *ed = sqlite3_column_text(stmt, 5);
+        record.end_datetime   = ed ? reinterpret_cast<const char *>(ed) : "";
+        const unsigned char *ow = sqlite3_column_text(stmt, 6);
+        record.owner          = ow ? reinterpret_cast<const char *>(ow) : "";
+        record.end_epoch      = sqlite3_column_int64(stmt, 7);
+        record.closed         = sqlite3_column_int(stmt, 8) != 0;
+        int auction_id = sqlite3_column_int(stmt, 0);
+        if (!record.closed && record.end_epoch != 0)
+        {
+            // Ends already passed while the server was down fire on the first tick
+            auction_closer.schedule(auction_id, record.end_epoch);
+            ++scheduled;
+        }
+        shardFor(auction_id).load(auction_id, std::move(record));
+        ++loaded;
+    }
+    std::cout << "Loaded " << loaded << " auctions into " << bid_shards.size() << " auction book shards, "
+              << scheduled << " scheduled to close\n";
+}
+
+// --------------------------------------------------------------------------------
+// Task executor. Route handlers hand their blocking SQLite reads (and login) to this
+// pool so that Crow's I/O threads go straight back to serving connections; writes go
+// through the group committer and bids through the shards, which complete their
+// responses themselves. The queue has its own lock and a fixed capacity; when it is
+// full submit() throws ExecutorFull and the caller sheds the request. Queue depth,
+// wait time and run time are tracked per task type. Password hashing runs on a
+// second, smaller executor (hasher), so a login storm can't take the workers that
+// serve reads.
+// --------------------------------------------------------------------------------
+enum class TaskType
+{
+    Read, // listing and history queries
+    Auth, // login's user lookup
+    Hash, // password hashing and verification, on the hasher
+    Count
+};
+
+const char *taskTypeName(TaskType type)
+{
+    switch (type)
+    {
+    case TaskType::Read:
+        return "read";
+    case TaskType::Auth:
+        return "auth";
+    case TaskType::Hash:
+        return "hash";
+    default:
+        return "unknown";
+    }
+}
+
+struct ExecutorFull : std::runtime_error
+{
+    ExecutorFull() : std::runtime_error("task queue is full") {}
+};
+
+class TaskExecutor
+{
+public:
+    void start(size_t threads, size_t capacity, const std::vector<int> &cpus = {})
+    {
+        capacity_ = capacity;
+        thread_count_ = threads;
+        running_ = true;
+        for (size_t i = 0; i < threads; ++i)
+        {
+            threads_.emplace_back([this, cpus]
+                                  {
+                pinCurrentThread(cpus);
+                run(); });
+        }
+    }
+
+    // Stops taking new tasks, runs the ones already queued and joins the threads
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_ = false;
+        }
+        cv_.notify_all();
+        for (auto &thread : threads_)
+        {
+            thread.join();
+        }
+        threads_.clear();
+    }
+
+    template <class F>
+    std::future<std::invoke_result_t<F>> submit(TaskType type, F &&fn)
+    {
+        using Result = std::invoke_result_t<F>;
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(fn));
+        std::future<Result> result = task->get_future();
+        Stats &stats = stats_[static_cast<size_t>(type)];
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!running_ || queue_.size() >= capacity_)
+            {
+                stats.rejected.fetch_add(1, std::memory_order_relaxed);
+                throw ExecutorFull();
+            }
+            queue_.push_back(Task{type, std::chrono::steady_clock::now(), [task]
+                                  { (*task)(); }});
+        }
+        stats.queued.fetch_add(1, std::memory_order_relaxed);
+        cv_.notify_one();
+        return result;
+    }
+
+    json metrics() const
+    {
+        json m;
+        for (size_t i = 0; i < static_cast<size_t>(TaskType::Count); ++i)
+        {
+            const Stats &stats = stats_[i];
+            unsigned long long completed = stats.completed.load();
+            json t;
+            t["queue_depth"]  = stats.queued.load();
+            t["completed"]    = completed;
+            t["rejected"]     = stats.rejected.load();
+            t["avg_wait_us"]  = completed ? stats.wait_ns.load() / 1000.0 / completed : 0.0;
+            t["max_wait_us"]  = stats.max_wait_ns.load() / 1000.0;
+            t["avg_run_us"]   = completed ? stats.run_ns.load() / 1000.0 / completed : 0.0;
+            m[taskTypeName(static_cast<TaskType>(i))] = t;
+        }
+        m["threads"]  = thread_count_;
+        m["capacity"] = capacity_;
+        return m;
+    }
+
+private:
+    struct Task
+    {
+        TaskType type;
+        std::chrono::steady_clock::time_point enqueued;
+        std::function<void()> run;
+    };
+
+    struct Stats
+    {
+        std::atomic<long long> queued{0};
+        std::atomic<unsigned long long> completed{0};
+        std::atomic<unsigned long long> rejected{0};
+        std::atomic<unsigned long long> wait_ns{0};
+        std::atomic<unsigned long long> max_wait_ns{0};
+        std::atomic<unsigned long long> run_ns{0};
+    };
+
+    void run()
+    {
+        while (true)
+        {
+            Task task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this]
+                         { return !queue_.empty() || !running_; });
+                if (queue_.empty())
+                {
+                    return;
+                }
+                task = std::move(queue_.front());
+                queue_.pop_front();
+            }
+
+            Stats &stats = stats_[static_cast<size_t>(task.type)];
+            stats.queued.fetch_sub(1, std::memory_order_relaxed);
+            auto started = std::chrono::steady_clock::now();
+            task.run();
+            auto finished = std::chrono::steady_clock::now();
+
+            unsigned long long wait = std::chrono::duration_cast<std::chrono::nanoseconds>(started - task.enqueued).count();
+            unsigned long long ran = std::chrono::duration_cast<std::chrono::nanoseconds>(finished - started).count();
+            stats.completed.fetch_add(1, std::memory_order_relaxed);
+            stats.wait_ns.fetch_add(wait, std::memory_order_relaxed);
+            stats.run_ns.fetch_add(ran, std::memory_order_relaxed);
+            unsigned long long max_wait = stats.max_wait_ns.load(std::memory_order_relaxed);
+            while (wait > max_wait && !stats.max_wait_ns.compare_exchange_weak(max_wait, wait))
+            {
+            }
+        }
+    }
+
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Task> queue_;
+    size_t capacity_ = 0;
+    size_t thread_count_ = 0;
+    bool running_ = false;
+    Stats stats_[static_cast<size_t>(TaskType::Count)];
+};
+
+TaskExecutor executor;
+TaskExecutor hasher;
+
+// Completes a response with a status code and body
+void finish(crow::response &res, int code, const std::string &body)
+{
+    res.code = code;
+    res.write(body);
+    res.end();
+}
+
+// Sheds a request that found its queue full, asking the client to retry shortly
+void rejectBusy(crow::response &res)
+{
+    res.add_header("Retry-After", "1");
+    finish(res, 503, "Server busy, try again.");
+}
+
+// Runs a handler's blocking work on the executor (the hasher for TaskType::Hash).
+// The work completes res itself; if it throws, or the queue is full, the response
+// is completed here instead.
+void offload(TaskType type, crow::response &res, std::function<void()> work)
+{
+    TaskExecutor &pool = type == TaskType::Hash ? hasher : executor;
+    try
+    {
+        pool.submit(type, [&res, type, work]
+                        {
+            try
+            {
+                work();
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << taskTypeName(type) << " task failed: " << e.what() << "\n";
+                res.code = 500;
+                res.write("Internal server error.");
+                res.end();
+            } });
+    }
+    catch (const ExecutorFull &)
+    {
+        rejectBusy(res);
+    }
+}
+
+// --------------------------------------------------------------------------------
+// Password hashing. Passwords are stored as "pbkdf2_sha256$<iterations>$<salt>$<hash>"
+// with the salt and PBKDF2-HMAC-SHA256 hash in base64. Hashing is slow on purpose,
+// so it only runs on the hasher, never while a database connection is held. Rows
+// written before passwords were hashed hold the password itself; they still log in,
+// and are rehashed on that login, as are hashes with fewer iterations than the
+// pbkdf2_iterations setting.
+// --------------------------------------------------------------------------------
+const std::string PASSWORD_SCHEME = "pbkdf2_sha256";
+const size_t PASSWORD_SALT_BYTES = 16;
+const size_t PASSWORD_HASH_BYTES = 32;
+
+// Iterations for new hashes, from the pbkdf2_iterations setting
+int pbkdf2_iterations = 100000;
+
+std::string pbkdf2(const std::string &password, const std::string &salt, int iterations)
+{
+    unsigned char hash[PASSWORD_HASH_BYTES];
+    if (PKCS5_PBKDF2_HMAC(password.data(), static_cast<int>(password.size()),
+                          reinterpret_cast<const unsigned char *>(salt.data()), static_cast<int>(salt.size()),
+                          iterations, EVP_sha256(), sizeof(hash), hash) != 1)
+    {
+        throw std::runtime_error("PBKDF2 failed");
+    }
+    return std::string(reinterpret_cast<const char *>(hash), sizeof(hash));
+}
+
+// Hashes a password with a new random salt, into the stored form
+std::string hashPassword(const std::string &password)
+{
+    unsigned char salt[PASSWORD_SALT_BYTES];
+    if (RAND_bytes(salt, sizeof(salt)) != 1)
+    {
+        throw std::runtime_error("RAND_bytes failed");
+    }
+    std::string salt_bytes(reinterpret_cast<const char *>(salt), sizeof(salt));
+    return PASSWORD_SCHEME + "$" + std::to_string(pbkdf2_iterations) + "$" +
+           jwt::base::encode<jwt::alphabet::base64>(salt_bytes) + "$" +
+           jwt::base::encode<jwt::alphabet::base64>(pbkdf2(password, salt_bytes, pbkdf2_iterations));
+}
+
+enum class PasswordCheck
+{
+    Mismatch,
+    Match,
+    MatchNeedsRehash // matched a plain or weaker stored password
+};
+
+// Checks a password against its stored form, comparing in constant time
+PasswordCheck checkPassword(const std::string &password, const std::string &stored)
+{
+    auto equal = [](const std::string &a, const std::string &b)
+    {
+        return a.size() == b.size() && CRYPTO_memcmp(a.data(), b.data(), a.size()) == 0;
+    };
+
+    if (stored.compare(0, PASSWORD_SCHEME.size() + 1, PASSWORD_SCHEME + "$") != 0)
+    {
+        return equal(password, stored) ? PasswordCheck::MatchNeedsRehash : PasswordCheck::Mismatch;
+    }
+
+    size_t iterations_at = PASSWORD_SCHEME.size() + 1;
+    size_t salt_at = stored.find('$', iterations_at);
+    size_t hash_at = salt_at == std::string::npos ? salt_at : stored.find('$', salt_at + 1);
+    if (hash_at == std::string::npos)
+    {
+        std::cerr << "Malformed password hash\n";
+        return PasswordCheck::Mismatch;
+    }
+    int iterations = 0;
+    std::string salt, hash;
+    try
+    {
+        iterations = std::stoi(stored.substr(iterations_at, salt_at - iterations_at));
+        salt = jwt::base::decode<jwt::alphabet::base64>(stored.substr(salt_at + 1, hash_at - salt_at - 1));
+        hash = jwt::base::decode<jwt::alphabet::base64>(stored.substr(hash_at + 1));
+    }
+    catch (const std::exception &)
+    {
+        iterations = 0;
+    }
+    if (iterations <= 0)
+    {
+        std::cerr << "Malformed password hash\n";
+        return PasswordCheck::Mismatch;
+    }
+
+    if (!equal(pbkdf2(password, salt, iterations), hash))
+    {
+        return PasswordCheck::Mismatch;
+    }
+    return iterations < pbkdf2_iterations ? PasswordCheck::MatchNeedsRehash : PasswordCheck::Match;
+}
+
+// Replaces a user's stored password with a new hash of it, with the next group-commit
+// batch. Must run on the hasher. Only replaces the row it was read from, so it can't
+// undo a password written since.
+void rehashPassword(const std::string &username, const std::string &password, const std::string &stored)
+{
+    std::string rehashed = hashPassword(password);
+    group_committer.submit([username, stored, rehashed](DbConnection &db)
+                           {
+        CachedStatement cached = db.prepare("UPDATE users SET password = ? WHERE username = ? AND password = ?;");
+        if (!cached) {
+            return false;
+        }
+        sqlite3_stmt* stmt = cached.get();
+        sqlite3_bind_text(stmt, 1, rehashed.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 2, username.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 3, stored.c_str(), -1, SQLITE_TRANSIENT);
+        return sqlite3_step(stmt) == SQLITE_DONE; }, [](bool durable)
+                           {
+        if (!durable) {
+            std::cerr << "Can't store a rehashed password; it is rehashed on the next login\n";
+        } });
+}
+
+// Function to execute SQL queries (non-transactional)
+bool executeSQL(DbConnection &db, const std::string &query)
+{
+    char *errMsg = nullptr;
+    int rc = sqlite3_exec(db.handle(), query.c_str(), nullptr, nullptr, &errMsg);
+    if (rc != SQLITE_OK)
+    {
+        std::cerr << "SQL error: " << (errMsg ? errMsg : "") << "\n";
+        sqlite3_free(errMsg);
+        return false;
+    }
+    return true;
+}
+
+// Function to check whether a table already has a column (for databases created
+// before the migration engine, which added columns on the fly)
+bool columnExists(DbConnection &db, const std::string &table, const std::string &column)
+{
+    sqlite3_stmt *stmt;
+    std::string sql = "PRAGMA table_info(" + table + ");";
+    if (sqlite3_prepare_v2(db.handle(), sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        return false;
+    }
+    bool found = false;
+    while (!found && sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        const unsigned char *name = sqlite3_column_text(stmt, 1);
+        found = name && column == reinterpret_cast<const char *>(name);
+    }
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+bool addColumnIfMissing(DbConnection &db, const std::string &table, const std::string &column, const std::string &type)
+{
+    return columnExists(db, table, column) ||
+           executeSQL(db, "ALTER TABLE " + table + " ADD COLUMN " + column + " " + type + ";");
+}
+
+// --------------------------------------------------------------------------------
+// Schema migrations. The schema version lives in PRAGMA user_version; every
+// migration above it is applied in order, each in its own transaction together
+// with the version bump, so a migration runs exactly once.
+// --------------------------------------------------------------------------------
+struct Migration
+{
+    int version;
+    const char *description;
+    std::function<bool(DbConnection &)> apply;
+};
+
+const std::vector<Migration> &migrations()
+{
+    static const std::vector<Migration> list = {
+        {1, "create users and auctions tables", [](DbConnection &db)
+         {
+             // Databases from before migrations already have these tables, possibly
+             // without the columns that used to be added on every boot
+             return executeSQL(db, "CREATE TABLE IF NOT EXISTS users ("
+                                   "id INTEGER PRIMARY KEY, "
+                                   "username TEXT UNIQUE, "
+                                   "password TEXT);") &&
+                    executeSQL(db, "CREATE TABLE IF NOT EXISTS auctions ("
+                                   "id INTEGER PRIMARY KEY, "
+                                   "item TEXT, "
+                                   "starting_price REAL, "
+                                   "highest_bid REAL, "
+                                   "highest_bidder TEXT, "
+                                   "end_datetime TEXT, "
+                                   "owner TEXT);") &&
+                    addColumnIfMissing(db, "auctions", "end_datetime", "TEXT") &&
+                    addColumnIfMissing(db, "auctions", "owner", "TEXT");
+         }},
+        {2, "index auctions by owner, end time and highest bidder", [](DbConnection &db)
+         {
+             return executeSQL(db, "CREATE INDEX IF NOT EXISTS idx_auctions_owner ON auctions(owner);") &&
+                    executeSQL(db, "CREATE INDEX IF NOT EXISTS idx_auctions_end_datetime ON auctions(end_datetime);") &&
+                    executeSQL(db, "CREATE INDEX IF NOT EXISTS idx_auctions_highest_bidder ON auctions(highest_bidder);");
+         }},
+        {3, "store auction end times as integer epochs", [](DbConnection &db)
+         {
+             if (!addColumnIfMissing(db, "auctions", "end_epoch", "INTEGER NOT NULL DEFAULT 0"))
+             {
+                 return false;
+             }
+
+             // Convert the existing text end times once, here, with the same parser
+             // /create_auction uses
+             std::vector<std::pair<long long, long long>> converted;
+             sqlite3_stmt *stmt;
+             if (sqlite3_prepare_v2(db.handle(), "SELECT id, end_datetime FROM auctions;", -1, &stmt, nullptr) != SQLITE_OK)
+             {
+                 return false;
+             }
+             while (sqlite3_step(stmt) == SQLITE_ROW)
+             {
+                 const unsigned char *ed = sqlite3_column_text(stmt, 1);
+                 long long epoch = parseDateTime(ed ? reinterpret_cast<const char *>(ed) : "");
+                 if (epoch != 0)
+                 {
+                     converted.emplace_back(sqlite3_column_int64(stmt, 0), epoch);
+                 }
+             }
+             sqlite3_finalize(stmt);
+
+             if (sqlite3_prepare_v2(db.handle(), "UPDATE auctions SET end_epoch = ? WHERE id = ?;", -1, &stmt, nullptr) != SQLITE_OK)
+             {
+                 return false;
+             }
+             bool ok = true;
+             for (const auto &row : converted)
+             {
+                 sqlite3_bind_int64(stmt, 1, row.second);
+                 sqlite3_bind_int64(stmt, 2, row.first);
+                 ok = ok && sqlite3_step(stmt) == SQLITE_DONE;
+                 sqlite3_reset(stmt);
+             }
+             sqlite3_finalize(stmt);
+
+             return ok &&
+                    executeSQL(db, "DROP INDEX IF EXISTS idx_auctions_end_datetime;") &&
+                    executeSQL(db, "CREATE INDEX IF NOT EXISTS idx_auctions_end_epoch ON auctions(end_epoch);");
+         }},
+        {4, "create append-only bids history table", [](DbConnection &db)
+         {
+             return executeSQL(db, "CREATE TABLE IF NOT EXISTS bids ("
+                                   "id INTEGER PRIMARY KEY, "
+                                   "auction_id INTEGER NOT NULL, "
+                                   "bidder TEXT NOT NULL, "
+                                   "amount REAL NOT NULL, "
+                                   "placed_at INTEGER NOT NULL);") &&
+                    executeSQL(db, "CREATE INDEX IF NOT EXISTS idx_bids_auction ON bids(auction_id, id);");
+         }},
+        {5, "record closed auctions and their winner", [](DbConnection &db)
+         {
+             return addColumnIfMissing(db, "auctions", "closed", "INTEGER NOT NULL DEFAULT 0") &&
+                    addColumnIfMissing(db, "auctions", "winner", "TEXT NOT NULL DEFAULT ''");
+         }},
+    };
+    return list;
+}
+
+int schemaVersion(DbConnection &db)
+{
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db.handle(), "PRAGMA user_version;", -1, &stmt, nullptr) != SQLITE_OK)
     {
-        // Ensure that every response has the CORS headers as well
-        res.add_header("Access-Control-Allow-Origin", "*");
-        res.add_header("Access-Control-Allow-Methods", "GET, POST, PUT, DELETE, OPTIONS");
-        res.add_header("Access-Control-Allow-Headers", "Content-Type, Authorization");
+        return -1;
     }
-};
-
-crow::App<CORS> app;
+    int version = sqlite3_step(stmt) == SQLITE_ROW ? sqlite3_column_int(stmt, 0) : -1;
+    sqlite3_finalize(stmt);
+    return version;
+}
 
-// Function to execute SQL with transaction support
-bool executeTransaction(const std::vector<std::string> &queries)
+// Function to bring the schema up to date; prints a report of what it did
+bool setupDatabase()
 {
-    std::lock_guard<std::mutex> lock(db_mutex);
-    sqlite3_exec(db, "BEGIN TRANSACTION;", nullptr, nullptr, nullptr);
+    auto db = db_pool.writer();
+    auto started = std::chrono::steady_clock::now();
+    int from = schemaVersion(*db);
+    if (from < 0)
+    {
+        std::cerr << "Can't read schema version: " << sqlite3_errmsg(db->handle()) << "\n";
+        return false;
+    }
 
-    for (const auto &query : queries)
+    int current = from;
+    for (const auto &migration : migrations())
     {
-        char *errMsg = nullptr;
-        int rc = sqlite3_exec(db, query.c_str(), nullptr, nullptr, &errMsg);
-        if (rc != SQLITE_OK)
+        if (migration.version <= current)
         {
-            sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
-            sqlite3_free(errMsg);
+            continue;
+        }
+
+        auto step_started = std::chrono::steady_clock::now();
+        bool ok = executeSQL(*db, "BEGIN IMMEDIATE;") &&
+                  migration.apply(*db) &&
+                  executeSQL(*db, "PRAGMA user_version = " + std::to_string(migration.version) + ";") &&
+                  executeSQL(*db, "COMMIT;");
+        if (!ok)
+        {
+            executeSQL(*db, "ROLLBACK;");
+            std::cerr << "Migration " << migration.version << " (" << migration.description << ") failed\n";
             return false;
         }
+        current = migration.version;
+
+        auto step_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - step_started).count();
+        std::cout << "Applied migration " << migration.version << ": " << migration.description
+                  << " (" << step_ms << " ms)\n";
     }
 
-    sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+    auto total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    std::cout << "Schema at version " << current << " (was " << from << "), migration took "
+              << total_ms << " ms\n";
     return true;
 }
 
-// Function to generate JWT Token (for authentication)
-std::string generateToken(const std::string &username)
-{
-    auto token = jwt::create()
-                     .set_issuer("auction_system")
-                     .set_subject(username)
-                     .set_expires_at(std::chrono::system_clock::now() + std::chrono::hours(1))
-                     .sign(jwt::algorithm::hs256{"secret"});
-    return token;
-}
-
-// Middleware to verify JWT Token
-bool verifyToken(const std::string &token)
+// Function to read an integer query parameter, falling back to a default
+long long queryParamInt(const crow::request &req, const char *name, long long fallback)
 {
+    const char *value = req.url_params.get(name);
+    if (!value || !*value)
+    {
+        return fallback;
+    }
     try
     {
-        auto decoded = jwt::decode(token);
-        auto username = decoded.get_subject();
-        return active_sessions.find(username) != active_sessions.end();
+        return std::stoll(value);
     }
     catch (const std::exception &)
     {
-        return false;
+        return fallback;
     }
 }
 
-// Function to get the highest bid for an auction
-double getHighestBid(int auction_id)
+// --------------------------------------------------------------------------------
+// Response cache for the auction listings. Bodies are stored as shared immutable
+// strings tagged with the version they were built at: /auctions pages use the global
+// listing version and /auctionsByUser uses the owner's version. /bid and
+// /create_auction bump both once their write is committed, so an entry built
+// before a change is simply never hit again. Sharing the body saves building and
+// serialising the page and keeps copies out of the cache lock, but a hit still
+// copies it once into the response: Crow sends crow::response::body, a std::string
+// the response owns, and has no way to send a buffer owned by someone else.
+// --------------------------------------------------------------------------------
+class ResponseCache
 {
-    std::lock_guard<std::mutex> lock(db_mutex);
-    const char *sql = "SELECT highest_bid FROM auctions WHERE id = ?;";
-    sqlite3_stmt *stmt;
-    sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-    sqlite3_bind_int(stmt, 1, auction_id);
+public:
+    using Body = std::shared_ptr<const std::string>;
 
-    double highest_bid = 0.0;
-    if (sqlite3_step(stmt) == SQLITE_ROW)
+    explicit ResponseCache(size_t capacity) : capacity_(capacity) {}
+
+    // Not thread-safe; called before the server starts
+    void setCapacity(size_t capacity)
     {
-        highest_bid = sqlite3_column_double(stmt, 0);
+        capacity_ = capacity;
     }
-    sqlite3_finalize(stmt);
-    return highest_bid;
-}
 
-// Helper function to get the end_datetime for an auction (as text)
-std::string getAuctionEndTime(int auction_id)
-{
-    std::lock_guard<std::mutex> lock(db_mutex);
-    const char *sql = "SELECT end_datetime FROM auctions WHERE id = ?;";
-    sqlite3_stmt *stmt;
-    sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-    sqlite3_bind_int(stmt, 1, auction_id);
+    // Returns the cached body for this key if it was built at this version
+    Body get(const std::string &key, unsigned long long version)
+    {
+        Body body;
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            auto it = entries_.find(key);
+            if (it != entries_.end() && it->second.version == version)
+            {
+                body = it->second.body;
+            }
+        }
+        if (body)
+        {
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            bytes_served_.fetch_add(body->size(), std::memory_order_relaxed);
+        }
+        else
+        {
+            misses_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return body;
+    }
+
+    void put(const std::string &key, unsigned long long version, Body body)
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        auto it = entries_.find(key);
+        if (it == entries_.end() && entries_.size() >= capacity_)
+        {
+            // Full: drop an arbitrary entry; stale ones are the common case anyway
+            entries_.erase(entries_.begin());
+        }
+        Entry &entry = entries_[key];
+        if (entry.version <= version)
+        {
+            entry = Entry{version, std::move(body)};
+        }
+    }
 
-    std::string end_time;
-    if (sqlite3_step(stmt) == SQLITE_ROW)
+    json metrics() const
     {
-        const unsigned char *text_ptr = sqlite3_column_text(stmt, 0);
-        if (text_ptr)
+        json m;
+        unsigned long long hits = hits_.load();
+        unsigned long long misses = misses_.load();
+        m["hits"]         = hits;
+        m["misses"]       = misses;
+        m["hit_ratio"]    = hits + misses ? static_cast<double>(hits) / (hits + misses) : 0.0;
+        m["bytes_served"] = bytes_served_.load();
         {
-            end_time = reinterpret_cast<const char *>(text_ptr);
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            m["entries"] = entries_.size();
         }
+        m["capacity"] = capacity_;
+        return m;
     }
-    sqlite3_finalize(stmt);
-    return end_time;
+
+private:
+    struct Entry
+    {
+        unsigned long long version = 0;
+        Body body;
+    };
+
+    size_t capacity_;
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+    std::atomic<unsigned long long> hits_{0};
+    std::atomic<unsigned long long> misses_{0};
+    std::atomic<unsigned long long> bytes_served_{0};
+};
+
+ResponseCache response_cache(4096); // sized from the config in main()
+
+std::atomic<unsigned long long> listing_version{1};
+std::unordered_map<std::string, unsigned long long> owner_versions;
+std::shared_mutex owner_versions_mutex;
+
+unsigned long long ownerVersion(const std::string &owner)
+{
+    std::shared_lock<std::shared_mutex> lock(owner_versions_mutex);
+    auto it = owner_versions.find(owner);
+    return it != owner_versions.end() ? it->second : 0;
 }
 
-// Parse a string datetime "YYYY-MM-DD HH:MM:SS" into a time_point
-// Returns time_point of epoch if parsing fails or string empty
-std::chrono::system_clock::time_point parseDateTime(const std::string &datetime_str)
+// Invalidates every cached listing that may include this owner's auctions
+void bumpListingVersions(const std::string &owner)
 {
-    if (datetime_str.empty())
+    listing_version.fetch_add(1);
+    std::unique_lock<std::shared_mutex> lock(owner_versions_mutex);
+    ++owner_versions[owner];
+}
+
+// --------------------------------------------------------------------------------
+// Auction listing projection: the columns a client may ask for with ?fields=, in the
+// order they are selected. id is always included since it is the page cursor.
+// --------------------------------------------------------------------------------
+enum class ColumnType
+{
+    Integer,
+    Real,
+    Text,
+    Boolean
+};
+
+struct AuctionColumn
+{
+    const char *name;
+    ColumnType type;
+};
+
+const std::vector<AuctionColumn> &auctionColumns()
+{
+    static const std::vector<AuctionColumn> columns = {
+        {"id", ColumnType::Integer},
+        {"item", ColumnType::Text},
+        {"starting_price", ColumnType::Real},
+        {"highest_bid", ColumnType::Real},
+        {"highest_bidder", ColumnType::Text},
+        {"end_datetime", ColumnType::Text},
+        {"owner", ColumnType::Text},
+        {"closed", ColumnType::Boolean},
+        {"winner", ColumnType::Text},
+    };
+    return columns;
+}
+
+// Function to turn a comma-separated ?fields= value into the selected columns
+// (every column when empty). Unknown names are ignored.
+std::vector<AuctionColumn> selectAuctionColumns(const std::string &fields)
+{
+    if (fields.empty())
     {
-        return std::chrono::system_clock::time_point{};
+        return auctionColumns();
     }
-    std::tm tm{};
-    std::istringstream ss(datetime_str);
-    ss >> std::get_time(&tm, "%Y-%m-%d %H:%M:%S");
-    if (ss.fail())
+
+    std::vector<std::string> requested;
+    std::stringstream ss(fields);
+    std::string name;
+    while (std::getline(ss, name, ','))
     {
-        // If parse fails, return epoch
-        return std::chrono::system_clock::time_point{};
+        requested.push_back(name);
     }
-    auto time_c = std::mktime(&tm);
-    return std::chrono::system_clock::from_time_t(time_c);
-}
 
-// Worker thread function
-void workerThread()
-{
-    while (running)
+    // Keep the canonical column order so each distinct projection maps to one
+    // cached statement no matter how the client orders its fields
+    std::vector<AuctionColumn> selected;
+    for (const auto &column : auctionColumns())
     {
-        std::function<void()> task;
+        if (std::string(column.name) == "id" ||
+            std::find(requested.begin(), requested.end(), column.name) != requested.end())
         {
-            std::unique_lock<std::mutex> lock(db_mutex);
-            cv.wait(lock, []
-                    { return !task_queue.empty() || !running; });
-            if (!running && task_queue.empty())
-            {
-                return;
-            }
-            task = std::move(task_queue.front());
-            task_queue.pop();
+            selected.push_back(column);
         }
-        task();
     }
+    return selected;
 }
 
-// Function to execute SQL queries (non-transactional)
-bool executeSQL(const std::string &query)
+json auctionRowToJson(sqlite3_stmt *stmt, const std::vector<AuctionColumn> &columns)
 {
-    std::lock_guard<std::mutex> lock(db_mutex);
-    char *errMsg = nullptr;
-    int rc = sqlite3_exec(db, query.c_str(), nullptr, nullptr, &errMsg);
-    if (rc != SQLITE_OK)
+    json auction;
+    for (size_t i = 0; i < columns.size(); ++i)
     {
-        std::cerr << "SQL error: " << (errMsg ? errMsg : "") << "\n";
-        sqlite3_free(errMsg);
-        return false;
+        int col = static_cast<int>(i);
+        switch (columns[i].type)
+        {
+        case ColumnType::Integer:
+            auction[columns[i].name] = sqlite3_column_int64(stmt, col);
+            break;
+        case ColumnType::Real:
+            auction[columns[i].name] = sqlite3_column_double(stmt, col);
+            break;
+        case ColumnType::Boolean:
+            auction[columns[i].name] = sqlite3_column_int(stmt, col) != 0;
+            break;
+        case ColumnType::Text:
+        {
+            const unsigned char *text = sqlite3_column_text(stmt, col);
+            auction[columns[i].name] = text ? reinterpret_cast<const char *>(text) : "";
+            break;
+        }
+        }
     }
-    return true;
+    return auction;
 }
 
-// Function to create or update the auctions table schema
-void setupDatabase()
+int main(int argc, char **argv)
 {
-    // Create the users table if it does not exist
-    executeSQL("CREATE TABLE IF NOT EXISTS users ("
-               "id INTEGER PRIMARY KEY, "
-               "username TEXT UNIQUE, "
-               "password TEXT);");
-
-    // Create the auctions table if it doesn't exist
-    executeSQL("CREATE TABLE IF NOT EXISTS auctions ("
-               "id INTEGER PRIMARY KEY, "
-               "item TEXT, "
-               "starting_price REAL, "
-               "highest_bid REAL, "
-               "highest_bidder TEXT, "
-               "end_datetime TEXT);");
-
-    // Attempt to add the 'end_datetime' column if it doesn't exist
-    executeSQL("ALTER TABLE auctions ADD COLUMN end_datetime TEXT;");
-
-    // --------------------------------------------------------------------------------
-    // NEW: Add a column "owner" (the username of whoever created the listing) if it
-    // doesn't already exist. This will fail silently if the column already exists.
-    // --------------------------------------------------------------------------------
-    executeSQL("ALTER TABLE auctions ADD COLUMN owner TEXT;");
-}
+    // Settings: defaults, then the config file, the environment and the flags
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--help")
+        {
+            config.printHelp(std::cout);
+            return 0;
+        }
+    }
+    if (!config.load(argc, argv))
+    {
+        return 1;
+    }
+    config.print(std::cout);
+    jwt_secret = config.getString("jwt_secret");
+    response_cache.setCapacity(static_cast<size_t>(config.getInt("response_cache_entries")));
+    token_cache.setCapacity(static_cast<size_t>(config.getInt("token_cache_entries")));
+    const std::string auth_tokens = config.getString("auth_tokens");
+    if (auth_tokens != "jwt" && auth_tokens != "opaque")
+    {
+        std::cerr << "auth_tokens must be jwt or opaque, not '" << auth_tokens << "'\n";
+        return 1;
+    }
+    auth_mode = auth_tokens == "opaque" ? AuthMode::Opaque : AuthMode::Jwt;
+    opaque_sessions.setCapacity(static_cast<size_t>(config.getInt("opaque_sessions")));
 
-int main()
-{
-    // Open the database
-    if (sqlite3_open("auction.db", &db))
+    // Open the database: one writer and a pool of readers, all in WAL mode
+    DbOptions db_options = dbOptionsFromConfig(config);
+    if (!db_pool.open(db_options))
     {
         std::cerr << "Can't open database\n";
         return 1;
     }
-    setupDatabase();
+    std::cout << "Database " << db_options.path << ": " << db_options.readers << " readers, synchronous="
+              << db_options.synchronous << ", cache_size=" << db_options.cache_size
+              << ", mmap_size=" << db_options.mmap_size << "\n";
+    if (!setupDatabase())
+    {
+        db_pool.close();
+        return 1;
+    }
+
+    // Split the auction book over the bid shards and fill it from the database
+    const int NUM_SHARDS = static_cast<int>(config.getInt("bid_shards"));
+    const size_t SHARD_MAILBOX = static_cast<size_t>(config.getInt("bid_mailbox"));
+    for (int i = 0; i < NUM_SHARDS; ++i)
+    {
+        bid_shards.push_back(std::make_unique<BidShard>(SHARD_MAILBOX));
+    }
+    std::cout << "Bid shards: " << NUM_SHARDS << ", mailbox capacity " << bid_shards.front()->mailboxCapacity() << "\n";
+    loadAuctionBook();
 
-    // Start worker threads for processing bids
-    const int NUM_WORKERS = std::max(1u, std::thread::hardware_concurrency());
-    std::vector<std::thread> workers;
-    workers.reserve(NUM_WORKERS);
-    for (int i = 0; i < NUM_WORKERS; ++i)
+    // Start the group-commit stage for bids and new auctions
+    GroupCommitOptions commit_options = groupCommitOptionsFromConfig(config);
+    group_committer.start(db_pool, commit_options);
+    std::cout << "Group commit: window " << commit_options.window_us << "us, max batch "
+              << commit_options.max_batch << "\n";
+
+    const std::vector<int> shard_cpus = config.getCpus("shard_cpus");
+    for (auto &shard : bid_shards)
     {
-        workers.emplace_back(workerThread);
+        shard->start(shard_cpus);
     }
+    auction_closer.start(commit_options.cpus);
+
+    // Start the task executor that runs the routes' blocking database work
+    const int NUM_WORKERS = static_cast<int>(config.getInt("workers"));
+    const int WORKER_QUEUE = static_cast<int>(config.getInt("worker_queue"));
+    executor.start(NUM_WORKERS, WORKER_QUEUE, config.getCpus("worker_cpus"));
+    std::cout << "Task executor: " << NUM_WORKERS << " workers, queue capacity " << WORKER_QUEUE << "\n";
+
+    // Start the hasher, which runs password hashing apart from the executor
+    pbkdf2_iterations = static_cast<int>(config.getInt("pbkdf2_iterations"));
+    const int NUM_HASHERS = static_cast<int>(config.getInt("hash_workers"));
+    const int HASH_QUEUE = static_cast<int>(config.getInt("hash_queue"));
+    hasher.start(NUM_HASHERS, HASH_QUEUE, config.getCpus("hash_cpus"));
+    std::cout << "Password hasher: " << NUM_HASHERS << " workers, queue capacity " << HASH_QUEUE
+              << ", PBKDF2 iterations " << pbkdf2_iterations << "\n";
+
+    // Erase expired sessions in the background
+    session_jitter = std::chrono::seconds(std::clamp(config.getInt("session_jitter_s"), 0LL, static_cast<long long>(SESSION_TTL.count() / 2)));
+    const long long SESSION_SWEEP_S = config.getInt("session_sweep_s");
+    active_sessions.startSweeper(std::chrono::seconds(SESSION_SWEEP_S), commit_options.cpus);
+    std::cout << "Session sweeper: every " << SESSION_SWEEP_S << "s; token lifetime " << SESSION_TTL.count()
+              << "s less up to " << session_jitter.count() << "s of jitter\n";
 
     // --------------------------------------------------------------------
     // User Registration
     // --------------------------------------------------------------------
-    CROW_ROUTE(app, "/register").methods("POST"_method)([](const crow::request &req)
+    CROW_ROUTE(app, "/register").methods("POST"_method)([](const crow::request &req, crow::response &res)
                                                         {
     auto data = json::parse(req.body);
     std::string username = data["username"];
     std::string password = data["password"];
 
-    // Insert user into database
-    std::lock_guard<std::mutex> lock(db_mutex);
-    sqlite3_stmt* stmt;
-    const char* sql = "INSERT INTO users (username, password) VALUES (?, ?);";
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        return crow::response(500, "Database error (prepare failed).");
-    }
-    sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 2, password.c_str(), -1, SQLITE_TRANSIENT);
-
-    if (sqlite3_step(stmt) != SQLITE_DONE) {
-        sqlite3_finalize(stmt);
-        return crow::response(400, "Username already exists or invalid input.");
-    }
-    sqlite3_finalize(stmt);
-
-    return crow::response(200, "Registration successful."); });
+    // Hash the password on the hasher, then insert the user with the next group-commit batch
+    offload(TaskType::Hash, res, [&res, username, password]
+            {
+        std::string stored_password = hashPassword(password);
+        group_committer.submit([username, stored_password](DbConnection &db) {
+            const char* sql = "INSERT INTO users (username, password) VALUES (?, ?);";
+            CachedStatement cached = db.prepare(sql);
+            if (!cached) {
+                return false;
+            }
+            sqlite3_stmt* stmt = cached.get();
+            sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_text(stmt, 2, stored_password.c_str(), -1, SQLITE_TRANSIENT);
+            return sqlite3_step(stmt) == SQLITE_DONE;
+        }, [&res](bool durable) {
+            if (!durable) {
+                return finish(res, 400, "Username already exists or invalid input.");
+            }
+            finish(res, 200, "Registration successful.");
+        }); }); });
 
     // --------------------------------------------------------------------
     // User Login
     // --------------------------------------------------------------------
-    CROW_ROUTE(app, "/login").methods("POST"_method)([](const crow::request &req)
+    CROW_ROUTE(app, "/login").methods("POST"_method)([](const crow::request &req, crow::response &res)
                                                      {
     auto data = json::parse(req.body);
     std::string username = data["username"];
     std::string password = data["password"];
 
-    // Query the database to verify credentials
-    std::lock_guard<std::mutex> lock(db_mutex);
-    sqlite3_stmt* stmt;
-    const char* sql = "SELECT password FROM users WHERE username = ? LIMIT 1;";
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        return crow::response(500, "Database error (prepare failed).");
-    }
-    sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_TRANSIENT);
+    offload(TaskType::Auth, res, [&res, username, password]
+            {
+        // Look up the stored password; the reader goes back to the pool before hashing
+        std::string stored_password;
+        {
+            auto db = db_pool.reader();
+            const char* sql = "SELECT password FROM users WHERE username = ? LIMIT 1;";
+            CachedStatement cached = db->prepare(sql);
+            if (!cached) {
+                return finish(res, 500, "Database error (prepare failed).");
+            }
+            sqlite3_stmt* stmt = cached.get();
+            sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_TRANSIENT);
 
-    std::string stored_password;
-    if (sqlite3_step(stmt) == SQLITE_ROW) {
-        stored_password = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-    }
-    sqlite3_finalize(stmt);
+            if (sqlite3_step(stmt) == SQLITE_ROW) {
+                stored_password = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+            }
+        }
+
+        if (stored_password.empty()) {
+            // username not found
+            return finish(res, 400, "Invalid username or password.");
+        }
 
-    if (stored_password.empty()) {
-        // username not found
-        return crow::response(400, "Invalid username or password.");
+        offload(TaskType::Hash, res, [&res, username, password, stored_password]
+                {
+            PasswordCheck check = checkPassword(password, stored_password);
+            if (check == PasswordCheck::Mismatch) {
+                return finish(res, 400, "Invalid username or password.");
+            }
+
+            std::optional<std::string> token = issueToken(username);
+            if (!token) {
+                return rejectBusy(res);
+            }
+            finish(res, 200, "Login successful. Token: " + *token);
+
+            if (check == PasswordCheck::MatchNeedsRehash) {
+                rehashPassword(username, password, stored_password);
+            } }); }); });
+
+    // --------------------------------------------------------------------
+    // User Logout: ends the user's session, which invalidates all of their tokens
+    // --------------------------------------------------------------------
+    CROW_ROUTE(app, "/logout").methods("POST"_method)([](const crow::request &req, crow::response &res)
+                                                      {
+    std::string token = req.get_header_value("Authorization");
+    std::optional<std::string> username = authenticate(token);
+    if (!username) {
+        res.code = 403;
+        res.write("Unauthorized.");
+        return res.end();
     }
 
-    if (stored_password == password) {
-        std::string token = generateToken(username);
-        active_sessions[username] = token;  // Store the token in active_sessions
-        return crow::response(200, "Login successful. Token: " + token);
-    } else {
-        return crow::response(400, "Invalid username or password.");
-    } });
+    endSession(*username, token);
+    res.code = 200;
+    res.write("Logged out.");
+    res.end(); });
 
     // --------------------------------------------------------------------
-    // Create an auction (with end_datetime & owner)
+    // Token refresh: trades a valid token for a new one with a fresh expiry,
+    // without a password check, so sessions don't end in a burst of logins
     // --------------------------------------------------------------------
-    CROW_ROUTE(app, "/create_auction").methods("POST"_method)([](const crow::request &req, crow::response &res)
-                                                              {
-    // Ensure user is authorized
+    CROW_ROUTE(app, "/refresh").methods("POST"_method)([](const crow::request &req, crow::response &res)
+                                                       {
     std::string token = req.get_header_value("Authorization");
-    if (!verifyToken(token)) {
+    std::optional<std::string> username = authenticate(token);
+    if (!username) {
         res.code = 403;
         res.write("Unauthorized.");
         return res.end();
     }
 
-    // Decode token again to get the username (owner)
-    std::string username;
-    try {
-        auto decoded = jwt::decode(token);
-        username = decoded.get_subject();
-    } catch (const std::exception&) {
+    std::optional<std::string> refreshed = refreshToken(*username, token);
+    if (!refreshed) {
+        // The opaque session table is full, or the session just ended (the retry gets 403)
+        return rejectBusy(res);
+    }
+    res.code = 200;
+    res.write("Token refreshed. Token: " + *refreshed);
+    res.end(); });
+
+    // --------------------------------------------------------------------
+    // Create an auction (with end_datetime & owner)
+    // --------------------------------------------------------------------
+    CROW_ROUTE(app, "/create_auction").methods("POST"_method)([](const crow::request &req, crow::response &res)
+                                                              {
+    // Ensure user is authorized; the token's user owns the new auction
+    std::string token = req.get_header_value("Authorization");
+    std::optional<std::string> owner = authenticate(token);
+    if (!owner) {
         res.code = 403;
-        res.write("Invalid Token.");
+        res.write("Unauthorized.");
         return res.end();
     }
+    std::string username = *owner;
 
     auto data = json::parse(req.body);
     std::string item_name     = data["item"];
@@ -343,23 +3927,32 @@ int main()
     std::string end_datetime  = data["end_datetime"];  // e.g. "2024-01-01 12:30:00"
 
     // Insert listing with "owner" = the user who created it
-    std::vector<std::string> queries = {
-        "INSERT INTO auctions (item, starting_price, highest_bid, highest_bidder, end_datetime, owner) VALUES ('"
-             + item_name + "', "
-             + std::to_string(starting_price) + ", "
-             + "0.0, '', '"
-             + end_datetime + "', '"
-             + username     + "');"
-    };
+    AuctionRecord record;
+    record.item           = item_name;
+    record.starting_price = starting_price;
+    record.end_datetime   = end_datetime;
+    record.end_epoch      = parseDateTime(end_datetime); // converted once, here
+    record.owner          = username;
 
-    if (!executeTransaction(queries)) {
-        res.code = 400;
-        res.write("Failed to create auction.");
-    } else {
-        res.code = 200;
-        res.write("Auction created successfully.");
-    }
-    res.end(); });
+    // Completed by the commit thread once the insert has been committed with its batch
+    auto auction_id = std::make_shared<long long>(-1);
+    group_committer.submit([record, auction_id](DbConnection &db)
+                           { return insertAuction(db, record, *auction_id); },
+                           [&res, record, username, auction_id](bool durable) mutable {
+        if (!durable) {
+            return finish(res, 400, "Failed to create auction.");
+        }
+        int id = static_cast<int>(*auction_id);
+        long long end_epoch = record.end_epoch;
+        // Goes through the shard's control queue, so a mailbox full of bids cannot
+        // hold up the commit thread here
+        shardFor(id).addAuction(id, std::move(record));
+        if (end_epoch != 0) {
+            auction_closer.schedule(id, end_epoch);
+        }
+        bumpListingVersions(username);
+        finish(res, 200, "Auction created successfully.");
+    }); });
 
     // --------------------------------------------------------------------
     // Get all auctions
@@ -368,36 +3961,65 @@ int main()
                                                        {
     std::string token = req.get_header_value("Authorization");
     std::cout << "Token: " << token << std::endl;
-    if (!verifyToken(token)) {
+    if (!authenticate(token)) {
         res.code = 403;
         res.write("Unauthorized.");
         return res.end();
     }
 
-    const char* sql = "SELECT id, item, starting_price, highest_bid, highest_bidder, end_datetime, owner "
-                      "FROM auctions;";
-    sqlite3_stmt* stmt;
-    sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-
-    json result = json::array();
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        json auction;
-        auction["id"]             = sqlite3_column_int(stmt, 0);
-        auction["item"]           = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        auction["starting_price"] = sqlite3_column_double(stmt, 2);
-        auction["highest_bid"]    = sqlite3_column_double(stmt, 3);
-        auction["highest_bidder"] = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
-        const unsigned char* ed   = sqlite3_column_text(stmt, 5);
-        auction["end_datetime"]   = ed ? reinterpret_cast<const char*>(ed) : "";
-        const unsigned char* ow   = sqlite3_column_text(stmt, 6);
-        auction["owner"]          = ow ? reinterpret_cast<const char*>(ow) : "";
-        result.push_back(auction);
+    // One page per request, keyed on id, so the rows read, the JSON built and the
+    // time a reader connection is held are bounded by ?limit= regardless of table size
+    long long after_id = queryParamInt(req, "after_id", 0);
+    long long limit    = std::min(std::max(queryParamInt(req, "limit", 100), 1LL), 500LL);
+    const char* fields = req.url_params.get("fields");
+    std::vector<AuctionColumn> columns = selectAuctionColumns(fields ? fields : "");
+
+    std::string sql = "SELECT ";
+    for (size_t i = 0; i < columns.size(); ++i) {
+        sql += (i ? ", " : "") + std::string(columns[i].name);
     }
-    sqlite3_finalize(stmt);
+    sql += " FROM auctions WHERE id > ? ORDER BY id LIMIT ?;";
 
-    res.code = 200;
-    res.write(result.dump());
-    res.end(); });
+    // The version is read before the query, so a bid committed meanwhile can only
+    // make this entry stale, never make a stale entry look current
+    std::string cache_key = "/auctions?" + std::to_string(after_id) + "&" + std::to_string(limit) + "&" + sql;
+    unsigned long long version = listing_version.load();
+    if (ResponseCache::Body body = response_cache.get(cache_key, version)) {
+        res.code = 200;
+        res.write(*body);
+        return res.end();
+    }
+
+    offload(TaskType::Read, res, [&res, sql, columns, cache_key, version, after_id, limit]
+            {
+        auto db = db_pool.reader();
+        CachedStatement cached = db->prepare(sql.c_str());
+        if (!cached) {
+            res.code = 500;
+            res.write("Database error.");
+            return res.end();
+        }
+        sqlite3_stmt* stmt = cached.get();
+        sqlite3_bind_int64(stmt, 1, after_id);
+        sqlite3_bind_int64(stmt, 2, limit);
+
+        json auctions = json::array();
+        long long last_id = 0;
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            last_id = sqlite3_column_int64(stmt, 0);
+            auctions.push_back(auctionRowToJson(stmt, columns));
+        }
+
+        json result;
+        result["auctions"]      = auctions;
+        // A full page may have more behind it; a short page is the last one
+        result["next_after_id"] = static_cast<long long>(auctions.size()) == limit ? json(last_id) : json(nullptr);
+
+        auto body = std::make_shared<const std::string>(result.dump());
+        response_cache.put(cache_key, version, body);
+        res.code = 200;
+        res.write(*body);
+        res.end(); }); });
 
     // --------------------------------------------------------------------
     // Gets all auction belonging to a user
@@ -407,43 +4029,55 @@ int main()
     {
         std::string token = req.get_header_value("Authorization");
         std::cout << "Token: " << token << std::endl;
-        if (!verifyToken(token)) {
+        if (!authenticate(token)) {
             res.code = 403;
             res.write("Unauthorized.");
             return res.end();
         }
     
-        const char* sql = "SELECT id, item, starting_price, highest_bid, highest_bidder, end_datetime, owner "
-                          "FROM auctions WHERE owner = ?;";
-        sqlite3_stmt* stmt;
-        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-            res.code = 500;
-            res.write("Database error.");
+        std::string cache_key = "/auctionsByUser/" + username;
+        unsigned long long version = ownerVersion(username);
+        if (ResponseCache::Body body = response_cache.get(cache_key, version)) {
+            res.code = 200;
+            res.write(*body);
             return res.end();
         }
+
+        offload(TaskType::Read, res, [&res, username, cache_key, version]
+                {
+            const char* sql = "SELECT id, item, starting_price, highest_bid, highest_bidder, end_datetime, owner "
+                              "FROM auctions WHERE owner = ?;";
+            auto db = db_pool.reader();
+            CachedStatement cached = db->prepare(sql);
+            if (!cached) {
+                res.code = 500;
+                res.write("Database error.");
+                return res.end();
+            }
+            sqlite3_stmt* stmt = cached.get();
     
-        sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_TRANSIENT);
-    
-        json result = json::array();
-        while (sqlite3_step(stmt) == SQLITE_ROW) {
-            json auction;
-            auction["id"]             = sqlite3_column_int(stmt, 0);
-            auction["item"]           = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-            auction["starting_price"] = sqlite3_column_double(stmt, 2);
-            auction["highest_bid"]    = sqlite3_column_double(stmt, 3);
-            auction["highest_bidder"] = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
-            const unsigned char* ed   = sqlite3_column_text(stmt, 5);
-            auction["end_datetime"]   = ed ? reinterpret_cast<const char*>(ed) : "";
-            const unsigned char* ow   = sqlite3_column_text(stmt, 6);
-            auction["owner"]          = ow ? reinterpret_cast<const char*>(ow) : "";
-            result.push_back(auction);
-        }
+            sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_TRANSIENT);
     
-        sqlite3_finalize(stmt);
+            json result = json::array();
+            while (sqlite3_step(stmt) == SQLITE_ROW) {
+                json auction;
+                auction["id"]             = sqlite3_column_int(stmt, 0);
+                auction["item"]           = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+                auction["starting_price"] = sqlite3_column_double(stmt, 2);
+                auction["highest_bid"]    = sqlite3_column_double(stmt, 3);
+                auction["highest_bidder"] = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
+                const unsigned char* ed   = sqlite3_column_text(stmt, 5);
+                auction["end_datetime"]   = ed ? reinterpret_cast<const char*>(ed) : "";
+                const unsigned char* ow   = sqlite3_column_text(stmt, 6);
+                auction["owner"]          = ow ? reinterpret_cast<const char*>(ow) : "";
+                result.push_back(auction);
+            }
     
-        res.code = 200;
-        res.write(result.dump());
-        res.end();
+            auto body = std::make_shared<const std::string>(result.dump());
+            response_cache.put(cache_key, version, body);
+            res.code = 200;
+            res.write(*body);
+            res.end(); });
     });
     
     // --------------------------------------------------------------------
@@ -452,40 +4086,76 @@ int main()
     CROW_ROUTE(app, "/auction/<int>").methods("GET"_method)([](const crow::request &req, crow::response &res, int auction_id)
                                                             {
     std::string token = req.get_header_value("Authorization");
-    if (!verifyToken(token)) {
+    if (!authenticate(token)) {
         res.code = 403;
         res.write("Unauthorized.");
         return res.end();
     }
 
-    const char* sql = "SELECT id, item, starting_price, highest_bid, highest_bidder, end_datetime, owner "
-                      "FROM auctions WHERE id = ?;";
-    sqlite3_stmt* stmt;
-    sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-    sqlite3_bind_int(stmt, 1, auction_id);
-
-    json result;
-    if (sqlite3_step(stmt) == SQLITE_ROW) {
-        result["id"]             = sqlite3_column_int(stmt, 0);
-        result["item"]           = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        result["starting_price"] = sqlite3_column_double(stmt, 2);
-        result["highest_bid"]    = sqlite3_column_double(stmt, 3);
-        result["highest_bidder"] = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
-        const unsigned char* ed  = sqlite3_column_text(stmt, 5);
-        result["end_datetime"]   = ed ? reinterpret_cast<const char*>(ed) : "";
-        const unsigned char* ow  = sqlite3_column_text(stmt, 6);
-        result["owner"]          = ow ? reinterpret_cast<const char*>(ow) : "";
+    // Served from the auction's shard, which always holds the latest accepted bid
+    bool queued = shardFor(auction_id).getAuction(auction_id, [&res, auction_id](const AuctionRecord* record) {
+        if (!record) {
+            return finish(res, 404, "Auction not found.");
+        }
+        finish(res, 200, auctionToJson(auction_id, *record).dump());
+    });
+    if (!queued) {
+        rejectBusy(res);
+    } });
+
+    // --------------------------------------------------------------------
+    // Bid history of an auction, oldest first. Pages with a keyset cursor on
+    // (auction_id, bid id): pass the returned next_after_id as ?after_id=
+    // --------------------------------------------------------------------
+    CROW_ROUTE(app, "/auction/<int>/bids").methods("GET"_method)([](const crow::request &req, crow::response &res, int auction_id)
+                                                                 {
+    std::string token = req.get_header_value("Authorization");
+    if (!authenticate(token)) {
+        res.code = 403;
+        res.write("Unauthorized.");
+        return res.end();
     }
-    sqlite3_finalize(stmt);
 
-    if (result.empty()) {
-        res.code = 404;
-        res.write("Auction not found.");
-    } else {
+    long long after_id = queryParamInt(req, "after_id", 0);
+    long long limit    = std::min(std::max(queryParamInt(req, "limit", 50), 1LL), 200LL);
+
+    offload(TaskType::Read, res, [&res, auction_id, after_id, limit]
+            {
+        const char* sql = "SELECT id, bidder, amount, placed_at FROM bids "
+                          "WHERE auction_id = ? AND id > ? ORDER BY id LIMIT ?;";
+        auto db = db_pool.reader();
+        CachedStatement cached = db->prepare(sql);
+        if (!cached) {
+            res.code = 500;
+            res.write("Database error.");
+            return res.end();
+        }
+        sqlite3_stmt* stmt = cached.get();
+        sqlite3_bind_int(stmt, 1, auction_id);
+        sqlite3_bind_int64(stmt, 2, after_id);
+        sqlite3_bind_int64(stmt, 3, limit);
+
+        json bids = json::array();
+        long long last_id = 0;
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            json bid;
+            last_id          = sqlite3_column_int64(stmt, 0);
+            bid["id"]        = last_id;
+            bid["bidder"]    = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+            bid["amount"]    = sqlite3_column_double(stmt, 2);
+            bid["placed_at"] = sqlite3_column_int64(stmt, 3);
+            bids.push_back(bid);
+        }
+
+        json result;
+        result["auction_id"]    = auction_id;
+        result["bids"]          = bids;
+        // A full page may have more behind it; a short page is the end of the history
+        result["next_after_id"] = static_cast<long long>(bids.size()) == limit ? json(last_id) : json(nullptr);
+
         res.code = 200;
         res.write(result.dump());
-    }
-    res.end(); });
+        res.end(); }); });
 
     // --------------------------------------------------------------------
     // Place a bid (checks if auction is not ended)
@@ -498,61 +4168,108 @@ int main()
     double bid_amount   = data["bid_amount"];
     std::string token   = req.get_header_value("Authorization");  // JWT Token
 
-    if (!verifyToken(token)) {
+    if (!authenticate(token)) {
         res.code = 403;
         res.write("Unauthorized.");
         return res.end();
     }
 
-    // Check if auction has ended
-    std::string end_datetime_str = getAuctionEndTime(auction_id);
-    auto end_tp = parseDateTime(end_datetime_str);
-    auto now = std::chrono::system_clock::now();
-
-    if (!end_datetime_str.empty() &&
-        end_tp != std::chrono::system_clock::time_point{} &&
-        now >= end_tp) {
-        // Auction has ended
-        res.code = 400;
-        res.write("Cannot bid on an ended auction.");
-        return res.end();
-    }
-
-    // Otherwise, check if the bid amount is higher than the current highest bid
-    double highest_bid = getHighestBid(auction_id);
-    if (bid_amount <= highest_bid) {
-        res.code = 400;
-        res.write("Bid must be higher than the current highest bid.");
-    } else {
-        // Use a transaction for atomic bid placement
-        std::vector<std::string> queries = {
-            "UPDATE auctions SET highest_bid = " + std::to_string(bid_amount)
-            + ", highest_bidder = '" + bidder
-            + "' WHERE id = " + std::to_string(auction_id) + ";"
-        };
-
-        if (!executeTransaction(queries)) {
-            res.code = 400;
-            res.write("Failed to place bid (transaction error).");
-        } else {
+    // Accept or reject the bid against the auction's shard in one compare-and-set.
+    // The shard completes the response (after the commit, for an accepted bid) with
+    // the resulting highest bid and bidder, so the client does not need to fetch
+    // the auction again before or after bidding.
+    // A full shard mailbox sheds the bid with 503 rather than queueing it.
+    bool queued = shardFor(auction_id).placeBid(auction_id, bid_amount, bidder, nowEpoch(), [&res, auction_id](const BidOutcome& outcome) {
+        const char* message = "Bid placed successfully.";
+        switch (outcome.status) {
+        case BidStatus::Accepted:
+            bumpListingVersions(outcome.owner);
             res.code = 200;
-            res.write("Bid placed successfully.");
+            break;
+        case BidStatus::NotFound:
+            res.code = 404;
+            message = "Auction not found.";
+            break;
+        case BidStatus::Ended:
+            res.code = 400;
+            message = "Cannot bid on an ended auction.";
+            break;
+        case BidStatus::TooLow:
+            res.code = 400;
+            message = "Bid must be higher than the current highest bid.";
+            break;
+        case BidStatus::Failed:
+            res.code = 500;
+            message = "Failed to place bid (transaction error).";
+            break;
         }
+
+        json result;
+        result["auction_id"]     = auction_id;
+        result["highest_bid"]    = outcome.highest_bid;
+        result["highest_bidder"] = outcome.highest_bidder;
+        result["message"]        = message;
+        res.set_header("Content-Type", "application/json");
+        res.write(result.dump());
+        res.end();
+    });
+    if (!queued) {
+        rejectBusy(res);
+    } });
+
+    // --------------------------------------------------------------------
+    // Runtime metrics
+    // --------------------------------------------------------------------
+    CROW_ROUTE(app, "/metrics").methods("GET"_method)([]()
+                                                     {
+    json metrics;
+    metrics["statement_cache"]["hits"]   = stmt_cache_hits.load();
+    metrics["statement_cache"]["misses"] = stmt_cache_misses.load();
+    metrics["group_commit"]              = group_committer.metrics();
+    metrics["response_cache"]            = response_cache.metrics();
+    metrics["sessions"]                  = active_sessions.metrics();
+    metrics["token_cache"]               = token_cache.metrics();
+    metrics["opaque_sessions"]           = opaque_sessions.metrics();
+    metrics["auction_closer"]            = auction_closer.metrics();
+    metrics["admission"]                 = admission.metrics();
+    metrics["executor"]                  = executor.metrics();
+    metrics["hasher"]                    = hasher.metrics();
+    metrics["bid_shards"]                = json::array();
+    for (const auto &shard : bid_shards) {
+        metrics["bid_shards"].push_back(shard->metrics());
     }
-    res.end(); });
+    return crow::response(200, metrics.dump()); });
 
-    // Start the server
-    app.port(8080).multithreaded().run();
+    // Per-class admission limits and the bid latency target that sheds reads
+    AdmissionOptions admission_options = admissionOptionsFromConfig(config);
+    admission.configure(admission_options);
+    std::cout << "Admission: in flight bid " << admission_options.bid_limit << ", auth " << admission_options.auth_limit
+              << ", read " << admission_options.read_limit << "; bid p99 target "
+              << admission_options.bid_p99_target_us / 1000 << "ms\n";
 
-    // Stop worker threads
-    running = false;
-    cv.notify_all();
-    for (auto &worker : workers)
+    // Start the server. Crow's I/O threads are created by run() and inherit this
+    // thread's CPU affinity.
+    pinCurrentThread(config.getCpus("crow_cpus"));
+    app.bindaddr(config.getString("bind_address"))
+        .port(static_cast<std::uint16_t>(config.getInt("port")))
+        .concurrency(static_cast<std::uint16_t>(config.getInt("crow_threads")))
+        .run();
+
+    // Stop the executors, the closer and the shards; work already queued still runs
+    // (the executor first, as its logins hand their hashing to the hasher)
+    executor.stop();
+    hasher.stop();
+    active_sessions.stopSweeper();
+    auction_closer.stop();
+    for (auto &shard : bid_shards)
     {
-        worker.join();
+        shard->stop();
     }
 
+    // Commit any writes that are still queued
+    group_committer.stop();
+
     // Close database
-    sqlite3_close(db);
+    db_pool.close();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,61 @@
+// Checks which tokens authenticate() accepts across login, logout and /refresh, in
+// both auth modes. authenticate() failing is what makes a route answer 403. Exits
+// non-zero on the first failure; see commands.txt for how to build it.
+#define main server_main
+#include "../server.cpp"
+#undef main
+
+int failures = 0;
+
+void check(bool ok, const char *mode, const char *what)
+{
+    std::cout << (ok ? "ok   " : "FAIL ") << mode << ": " << what << "\n";
+    failures += ok ? 0 : 1;
+}
+
+// JWTs with the same subject and exp are identical, so a new login has to land on
+// a later second than the token it is compared with
+void nextSecond()
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+}
+
+void run(AuthMode mode, const char *name)
+{
+    auth_mode = mode;
+    const std::string user = std::string("tester_") + name;
+
+    std::string first = issueToken(user).value();
+    check(authenticate(first) == user, name, "a new login's token is accepted");
+
+    endSession(user, first);
+    check(!authenticate(first), name, "the token is refused after logout");
+
+    nextSecond();
+    std::string second = issueToken(user).value();
+    check(authenticate(second) == user, name, "logging in again gives a token that is accepted");
+    check(!authenticate(first), name, "a token from before the logout stays refused after logging in again");
+
+    nextSecond();
+    std::string other = issueToken(user).value();
+    check(authenticate(second) == user && authenticate(other) == user, name,
+          "two logins of the same user are both accepted");
+
+    std::optional<std::string> refreshed = refreshToken(user, second);
+    check(refreshed && authenticate(*refreshed) == user, name, "the refreshed token is accepted");
+    check(!authenticate(second), name, "the token traded in by a refresh is refused");
+    check(authenticate(other) == user, name, "a refresh leaves the user's other tokens alone");
+
+    endSession(user, other);
+    check(!authenticate(other) && !(refreshed && authenticate(*refreshed)), name,
+          "logout refuses all of the session's tokens");
+    check(!refreshToken(user, other), name, "a refresh after logout is refused");
+}
+
+int main()
+{
+    run(AuthMode::Jwt, "jwt");
+    run(AuthMode::Opaque, "opaque");
+    std::cout << (failures == 0 ? "All checks passed\n" : "Some checks failed\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -1,5 +1,6 @@
 import React, { useState, useEffect } from 'react';
 import { Routes, Route, Link, Navigate, useNavigate } from 'react-router-dom';
+import axios from 'axios';
 import Home from './pages/Home/Home';
 import Login from './pages/Login/Login';
 import Register from './pages/Register/Register';
@@ -34,6 +35,15 @@ function App() {
   }, []);
 
   const handleLogout = () => {
+    // End the session on the server too; the local logout doesn't wait for it
+    const token = localStorage.getItem('token');
+    if (token) {
+      axios.post('http://localhost:8080/logout', null, {
+        headers: {
+          'Authorization': token
+        }
+      }).catch(() => {});
+    }
     localStorage.removeItem('token');
     localStorage.removeItem('username');
     setIsAuthenticated(false);
@@ -49,12 +49,6 @@ export default function AuctionItem() {
 
     const handlePlaceBid = async (e) => {
         e.preventDefault();
-        const checkChange = await axios.get(`http://localhost:8080/auction/${id}`, {
-            headers: {
-                'Authorization': token
-            }
-        });
-        setAuction(checkChange.data);
 
         setBidError('');
         setBidSuccess('');
@@ -75,8 +69,20 @@ export default function AuctionItem() {
             return;
         }
 
+        // The bid response carries the auction's highest bid and bidder after the
+        // attempt, whether it was accepted or not, so no extra fetch is needed
+        const applyBidState = (data) => {
+            if (data && data.highest_bid !== undefined) {
+                setAuction(prev => ({
+                    ...prev,
+                    highest_bid: data.highest_bid,
+                    highest_bidder: data.highest_bidder
+                }));
+            }
+        };
+
         try {
-            await axios.post('http://localhost:8080/bid',
+            const response = await axios.post('http://localhost:8080/bid',
                 {
                     auction_id: Number(id),
                     bidder: username,
@@ -90,20 +96,14 @@ export default function AuctionItem() {
                 }
             );
 
+            applyBidState(response.data);
             setBidSuccess(`Your bid of $${amount.toFixed(2)} was placed successfully!`);
             setBidAmount('');
 
-            // Refresh auction data to show updated bid
-            const response = await axios.get(`http://localhost:8080/auction/${id}`, {
-                headers: {
-                    'Authorization': token
-                }
-            });
-
-            setAuction(response.data);
-
         } catch (err) {
-            setBidError('Failed to place bid: ' + (err.response?.data || err.message));
+            const data = err.response?.data;
+            applyBidState(data);
+            setBidError('Failed to place bid: ' + (data?.message || data || err.message));
         }
     };
 
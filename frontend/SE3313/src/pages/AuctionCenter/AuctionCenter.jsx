@@ -1,50 +1,84 @@
-import React, { useState, useEffect } from 'react';
+import React, { useState, useEffect, useCallback } from 'react';
 import { Link, useNavigate } from 'react-router-dom';
 import axios from 'axios';
 import './AuctionCenter.css';
 
+// The listing is paged by id; a page is fetched at a time, as the user asks for more
+const PAGE_SIZE = 50;
+const FIELDS = 'id,item,starting_price,highest_bid,highest_bidder,end_datetime,owner';
+
 export default function AuctionCenter() {
     const [auctions, setAuctions] = useState([]);
     const [filteredAuctions, setFilteredAuctions] = useState([]);
     const [searchTerm, setSearchTerm] = useState('');
     const [loading, setLoading] = useState(true);
+    const [loadingMore, setLoadingMore] = useState(false);
+    const [nextAfterId, setNextAfterId] = useState(null);
     const [error, setError] = useState(null);
     const token = localStorage.getItem('token');
     const username = localStorage.getItem('username');
     const navigate = useNavigate();
 
-    useEffect(() => {
-        const fetchAuctions = async () => {
-            try {
-                setLoading(true);
+    // Fetches the page after the given id; null from next_after_id means it was the last
+    const fetchPage = useCallback(async (afterId) => {
+        if (!token) {
+            throw new Error('No authentication token found');
+        }
+        const response = await axios.get('http://localhost:8080/auctions', {
+            headers: {
+                'Authorization': token
+            },
+            params: {
+                after_id: afterId,
+                limit: PAGE_SIZE,
+                fields: FIELDS
+            }
+        });
+        return response.data;
+    }, [token]);
 
-                if (!token) {
-                    throw new Error('No authentication token found');
-                }
+    const handleError = useCallback((err) => {
+        setError('Failed to load auctions. ' + (err.response?.data || err.message));
 
-                const response = await axios.get('http://localhost:8080/auctions', {
-                    headers: {
-                        'Authorization': token
-                    }
-                });
+        // If unauthorized, redirect to login
+        if (err.response?.status === 403) {
+            setTimeout(() => navigate('/login'), 2000);
+        }
+    }, [navigate]);
 
-                setAuctions(response.data);
-                setFilteredAuctions(response.data);
+    useEffect(() => {
+        const fetchFirstPage = async () => {
+            try {
+                setLoading(true);
+                const page = await fetchPage(0);
+                setAuctions(page.auctions);
+                setNextAfterId(page.next_after_id);
                 setError(null);
             } catch (err) {
-                setError('Failed to load auctions. ' + (err.response?.data || err.message));
-
-                // If unauthorized, redirect to login
-                if (err.response?.status === 403) {
-                    setTimeout(() => navigate('/login'), 2000);
-                }
+                handleError(err);
             } finally {
                 setLoading(false);
             }
         };
 
-        fetchAuctions();
-    }, [token, navigate]);
+        fetchFirstPage();
+    }, [fetchPage, handleError]);
+
+    const loadMore = async () => {
+        if (nextAfterId === null || loadingMore) {
+            return;
+        }
+        try {
+            setLoadingMore(true);
+            const page = await fetchPage(nextAfterId);
+            setAuctions(prev => prev.concat(page.auctions));
+            setNextAfterId(page.next_after_id);
+        } catch (err) {
+            handleError(err);
+        } finally {
+            setLoadingMore(false);
+        }
+    };
 
     // Handle search functionality
     useEffect(() => {
@@ -111,7 +145,7 @@ export default function AuctionCenter() {
                     <input
                         type="text"
                         className="search-input"
-                        placeholder="Search auctions by item or seller..."
+                        placeholder="Search loaded auctions by item or seller..."
                         value={searchTerm}
                         onChange={(e) => setSearchTerm(e.target.value)}
                     />
@@ -198,6 +232,18 @@ export default function AuctionCenter() {
                     ))}
                 </div>
             )}
+
+            {nextAfterId !== null && (
+                <div className="load-more-container">
+                    <button
+                        onClick={loadMore}
+                        className="load-more-btn"
+                        disabled={loadingMore}
+                    >
+                        {loadingMore ? 'Loading...' : 'Load more auctions'}
+                    </button>
+                </div>
+            )}
         </div>
     );
 }
\ No newline at end of file